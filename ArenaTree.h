@@ -0,0 +1,377 @@
+/**
+ * This N-ary tree offers the same ID-based interface and serialization
+ * format as Tree, but stores every node in one contiguous pool instead of
+ * allocating each node on its own. Nodes link to each other through indices
+ * into the pool (parent, first child, last child, next sibling), so building
+ * a tree costs amortized vector growth rather than two heap allocations per
+ * node, and tearing it down is a single release of the pool.
+ *
+ *
+ * POOL REPRESENTATION
+ * ___________________
+ *
+ *      1                 index:       0  1  2  3  4  5  6  7
+ *     /|\                value:       1  2  3  4  5  6  7  8
+ *    2 3 4               firstChild:  1  4  6  -  -  -  -  -
+ *   /| |\                nextSibling: -  2  3  -  5  -  7  -
+ *  5 6 7 8
+ *
+ * A node's ID is its index in the pool. Removed nodes leave a dead slot
+ * behind so IDs are never reused, matching Tree's ID semantics.
+ *
+ */
+
+#ifndef ARENATREE_H
+#define ARENATREE_H
+
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Tree.h"
+
+/**
+ * @brief Implements an N-ary tree whose nodes live in a contiguous pool.
+ *
+ * Drop-in alternative to Tree for large, mostly append-only trees. It shares
+ * Tree's public ID-based API and its text serialization, so trees can be
+ * saved by one and loaded by the other. Type T has the same requirements
+ * as for Tree.
+ *
+ * @attention Not thread-safe; avoid concurrent modifications.
+ * @attention Throws exceptions for errors that could compromise tree integrity.
+ */
+template <typename T>
+class ArenaTree {
+    static_assert(has_stream_operators<T>::value, "Type T must have out-stream (<<) and in-stream (>>) operators defined.");
+    static_assert(has_default_constructor<T>::value, "Type T must have a default constructor defined.");
+    static_assert(has_equality_operator<T>::value, "Type T must have an equality (==) operator defined.");
+
+private:
+    static constexpr int NONE = -1; // Index used for missing links
+
+    struct Slot {
+        T value;
+        int parent = NONE;
+        int firstChild = NONE;
+        int lastChild = NONE; // Kept so appending a child doesn't walk the sibling list
+        int nextSibling = NONE;
+        bool alive = true;
+    };
+
+    std::vector<Slot> pool; // Every node ever created, indexed by ID
+    int rootID = NONE;
+
+    /**
+     * @brief Finds a live slot by ID.
+     *
+     * @param nodeID ID of the node.
+     * @return int The validated ID.
+     * @throw std::invalid_argument If the ID is out of range or the node was removed.
+     */
+    int checkedID(int nodeID) const {
+        if (nodeID < 0 || nodeID >= static_cast<int>(pool.size()) || !pool[nodeID].alive) {
+            std::stringstream errMsg;
+            errMsg << "Node with ID " << nodeID << " does not exist";
+            throw std::invalid_argument(errMsg.str());
+        }
+        return nodeID;
+    }
+
+    /**
+     * @brief Adds a slot and links it as the last child of a parent.
+     *
+     * @param parentID Index of the parent, or NONE for the root.
+     * @param value Value to move into the new slot.
+     * @return int ID of the new node.
+     */
+    int link(int parentID, T&& value) {
+        int nodeID = static_cast<int>(pool.size());
+        pool.push_back(Slot{std::move(value), parentID});
+        if (parentID != NONE) {
+            Slot& parent = pool[parentID];
+            if (parent.lastChild == NONE) {
+                parent.firstChild = nodeID;
+            } else {
+                pool[parent.lastChild].nextSibling = nodeID;
+            }
+            parent.lastChild = nodeID;
+        }
+        return nodeID;
+    }
+
+    /**
+     * @brief Returns the next node in pre-order after a node's subtree, bounded by a subtree root.
+     *
+     * Climbs parent links until a node with a next sibling is found, which lets
+     * pre-order walks run without a stack. Each climbed level is reported to
+     * `onClose` so callers can emit end-of-children tokens.
+     *
+     * @param nodeID Node whose subtree has been fully visited.
+     * @param subtreeRoot Walk stops when this node is closed.
+     * @param onClose Called once for every node whose children list ends.
+     * @return int The next node to visit, or NONE when the walk is over.
+     */
+    template <typename F>
+    int nextAfterSubtree(int nodeID, int subtreeRoot, F&& onClose) const {
+        while (true) {
+            onClose(nodeID);
+            if (nodeID == subtreeRoot) {
+                return NONE;
+            }
+            if (pool[nodeID].nextSibling != NONE) {
+                return pool[nodeID].nextSibling;
+            }
+            nodeID = pool[nodeID].parent;
+        }
+    }
+
+    /**
+     * @brief Builds a tree from its linearized representation in one pass.
+     *
+     * @param linearized Linearized tree data, as produced by Tree's parser.
+     * @return ArenaTree<T> The reconstructed tree.
+     */
+    static ArenaTree<T> delinearize(std::vector<std::optional<T>>&& linearized) {
+        ArenaTree<T> tree;
+        size_t nodeCount = 0;
+        for (const auto& optValue : linearized) {
+            nodeCount += optValue.has_value();
+        }
+        tree.pool.reserve(nodeCount);
+
+        int current = NONE;
+        for (auto& optValue : linearized) {
+            // Handle node value
+            if (optValue.has_value()) {
+                if (tree.rootID != NONE && current == NONE) {
+                    throw std::invalid_argument("Invalid tree serialization: nodes found after the root's subtree ended");
+                }
+                current = tree.link(current, std::move(*optValue));
+                if (tree.rootID == NONE) {
+                    tree.rootID = current;
+                }
+            // Handle end-of-children token
+            } else if (current != NONE) {
+                current = tree.pool[current].parent;
+            }
+        }
+        return tree;
+    }
+
+public:
+    /**
+     * @brief Initializes an empty tree.
+     */
+    ArenaTree() {
+        Tree<T>::T_compatible_check();
+    }
+
+    /**
+     * @brief Constructs a tree with a root node.
+     *
+     * @param value The value for the root node.
+     */
+    explicit ArenaTree(T value) {
+        Tree<T>::T_compatible_check();
+        setRoot(std::move(value));
+    }
+
+    /**
+     * @brief Reserves pool capacity ahead of a known number of appends.
+     *
+     * @param nodeCount Total number of nodes expected.
+     */
+    void reserve(size_t nodeCount) {
+        pool.reserve(nodeCount);
+    }
+
+    /**
+     * @brief Sets the tree's root node.
+     *
+     * @param value The value for the root node.
+     * @return int The ID of the root node.
+     * @throw std::logic_error If attempting to set the root on a non-empty tree.
+     */
+    int setRoot(T value) {
+        if (rootID != NONE) {
+            throw std::logic_error("The root node has already been set");
+        }
+        rootID = link(NONE, std::move(value));
+        return rootID;
+    }
+
+    /**
+     * @brief Adds a child node under a specified parent.
+     *
+     * @param parentID ID of the parent node.
+     * @param value Value for the new node.
+     * @return int ID of the new node.
+     * @throw std::invalid_argument If the parent node ID is invalid.
+     */
+    int appendNode(int parentID, T value) {
+        if (parentID < 0 || parentID >= static_cast<int>(pool.size()) || !pool[parentID].alive) {
+            std::stringstream errMsg;
+            errMsg << "Parent node with ID " << parentID << " does not exist.";
+            throw std::invalid_argument(errMsg.str());
+        }
+        return link(parentID, std::move(value));
+    }
+
+    /**
+     * @brief Removes a node and its subtree.
+     *
+     * Unlinks the node from its parent and marks every slot in the subtree as
+     * dead. Dead slots release their values but keep their place in the pool,
+     * so the IDs of other nodes are unaffected.
+     *
+     * @param nodeID ID of the node to remove.
+     * @throw std::invalid_argument If the node is the root or the ID is invalid.
+     */
+    void removeNode(int nodeID) {
+        if (nodeID == getRootID()) {
+            throw std::invalid_argument("The root node cannot be removed");
+        }
+        checkedID(nodeID);
+
+        // unlink the node from its parent's list of children
+        Slot& parent = pool[pool[nodeID].parent];
+        int previous = NONE;
+        for (int child = parent.firstChild; child != nodeID; child = pool[child].nextSibling) {
+            previous = child;
+        }
+        if (previous == NONE) {
+            parent.firstChild = pool[nodeID].nextSibling;
+        } else {
+            pool[previous].nextSibling = pool[nodeID].nextSibling;
+        }
+        if (parent.lastChild == nodeID) {
+            parent.lastChild = previous;
+        }
+
+        // mark the subtree dead, walking it in pre-order without recursion
+        int current = nodeID;
+        while (current != NONE) {
+            int next = pool[current].firstChild;
+            if (next == NONE) {
+                next = nextAfterSubtree(current, nodeID, [](int) {});
+            }
+            pool[current].alive = false;
+            pool[current].value = T();
+            current = next;
+        }
+        pool[nodeID].nextSibling = NONE;
+    }
+
+    /**
+     * @brief Gets the root node's ID.
+     *
+     * @return int The root node's ID, or -1 if absent.
+     */
+    int getRootID() const noexcept {
+        return rootID;
+    }
+
+    /**
+     * @brief Lists a node's children IDs.
+     *
+     * @param nodeID ID of the node to query.
+     * @return std::vector<int> IDs of the node's children.
+     * @throw std::invalid_argument If node ID is invalid.
+     */
+    std::vector<int> getChildrenIDs(int nodeID) const {
+        std::vector<int> childrenIDs;
+        for (int child = pool[checkedID(nodeID)].firstChild; child != NONE; child = pool[child].nextSibling) {
+            childrenIDs.push_back(child);
+        }
+        return childrenIDs;
+    }
+
+    /**
+     * @brief Retrieves a node's value.
+     *
+     * @param nodeID ID for value retrieval.
+     * @return T const& The node's value.
+     * @throw std::invalid_argument If node ID is invalid.
+     */
+    const T& getValue(int nodeID) const {
+        return pool[checkedID(nodeID)].value;
+    }
+
+    /**
+     * @brief Accesses a node's value by ID. Equivalent to `getValue`.
+     *
+     * @param nodeID ID of the node.
+     * @return T const& Value of the node.
+     * @throw std::invalid_argument If node is missing.
+     */
+    const T& operator[](int nodeID) const {
+        return pool[checkedID(nodeID)].value;
+    }
+
+    /**
+     * @brief Serializes the tree to the same string format as Tree::serialize.
+     *
+     * @param compactRuns Write consecutive end-of-children tokens as one "[X*n]" line.
+     * @return std::string The tree's serialized form.
+     */
+    std::string serialize(bool compactRuns = false) const {
+        std::ostringstream serialized;
+        int nodeCount = 0;
+        int current = rootID;
+        while (current != NONE) {
+            serialized << "[" << nodeCount++ << "]: " << pool[current].value << "\n";
+            int next = pool[current].firstChild;
+            if (next == NONE) {
+                size_t closed = 0;
+                next = nextAfterSubtree(current, rootID, [&](int) { ++closed; });
+                Tree<T>::writeEndOfChildren(serialized, closed, compactRuns);
+            }
+            current = next;
+        }
+        return serialized.str();
+    }
+
+    /**
+     * @brief Rebuilds a tree from the string format written by Tree or ArenaTree.
+     *
+     * Parsing errors are reported the same way as Tree::deserialize.
+     *
+     * @param serialized Serialized tree string.
+     * @return ArenaTree<T> The deserialized tree.
+     */
+    static ArenaTree<T> deserialize(const std::string& serialized) {
+        return delinearize(Tree<T>::parseLinearized(std::string_view(serialized)));
+    }
+
+    /**
+     * @brief Displays the tree's linearized form in the console.
+     */
+    void printLinearized() const {
+        std::cout << "[ ";
+        bool first = true;
+        auto separate = [&]() {
+            if (!first) {
+                std::cout << ", ";
+            }
+            first = false;
+        };
+        int current = rootID;
+        while (current != NONE) {
+            separate();
+            std::cout << pool[current].value;
+            int next = pool[current].firstChild;
+            if (next == NONE) {
+                next = nextAfterSubtree(current, rootID, [&](int) { separate(); std::cout << "X"; });
+            }
+            current = next;
+        }
+        std::cout << " ]";
+        std::cout << std::endl;
+    }
+};
+
+#endif // ARENATREE_H
@@ -0,0 +1,398 @@
+/**
+ * Low-level helpers for the binary storyline encoding.
+ *
+ * The binary encoding mirrors the text serialization produced by Tree::serialize():
+ * nodes are written in pre-order, but instead of "[X]" end-of-children tokens each
+ * node records how many children follow it. Counts and lengths are stored as
+ * LEB128 varints, payloads as length-prefixed byte strings.
+ *
+ * Version 1 gives every record a header holding its child count. Version 2,
+ * which is what the writer emits, shares one header between the nodes of a chain:
+ * a header is either a node's `childCount << 1`, or `(length << 1) | 1` for
+ * a chain of `length` nodes that each have exactly one child. A chain header
+ * is followed by the chain's payloads back to back, and the last chain node's
+ * child is the next record. Readers accept both versions, and reject flag
+ * bits they don't know rather than guess at the layout. Chains only pay off
+ * for linear stretches: varian_wrynn.txt has one single-child node in 3245
+ * and encodes to the same size either way, while a 200k-node chain shrinks
+ * from 1,488,907 to 1,288,914 bytes.
+ *
+ *
+ * BINARY REPRESENTATION
+ * _____________________
+ *
+ * "TRB1"                 <--- 4 byte magic
+ * version  (1 byte)
+ * flags    (1 byte)
+ * nodeCount (varint)
+ * header (varint), payload(s)     <--- records covering nodeCount nodes, in pre-order
+ * [index footer]                   <--- only when the INDEX flag is set
+ *
+ *
+ * INDEX FOOTER
+ * ____________
+ *
+ * offset (u64), childCount (u32), subtreeSize (u32)   <--- one fixed-size entry per node, in pre-order
+ * indexOffset (u64)                <--- where the first entry starts
+ * checksum (u64)                   <--- FNV-1a of the entries
+ * "TRBX"                           <--- 4 byte footer magic
+ *
+ * Entry N describes the node written as "[N]" by Tree::serialize(). `offset`
+ * is the byte position of the node's payload in version 2, since chain nodes
+ * have no header of their own, and of its child count in version 1. The
+ * node's subtree is the records from entry N up to entry N + subtreeSize (or the index itself),
+ * so a reader can seek to any node or cut out any subtree without decoding
+ * the rest of the file. Fixed-width fields are little-endian.
+ *
+ */
+
+#ifndef BINARYCODEC_H
+#define BINARYCODEC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+// Magic bytes identifying a binary serialized tree.
+inline constexpr char BINARY_TREE_MAGIC[] = {'T', 'R', 'B', '1'};
+inline constexpr std::size_t BINARY_TREE_MAGIC_SIZE = sizeof(BINARY_TREE_MAGIC);
+// Version written by Tree::serializeBinary; it adds chain records to version 1
+inline constexpr std::uint8_t BINARY_TREE_VERSION = 2;
+// Version with one child count per record, still used by the interned string-table format
+inline constexpr std::uint8_t BINARY_TREE_VERSION_UNCHAINED = 1;
+// magic + version + flags
+inline constexpr std::size_t BINARY_TREE_HEADER_SIZE = BINARY_TREE_MAGIC_SIZE + 2;
+// Flag bit set when the file ends with an index footer.
+inline constexpr std::uint8_t BINARY_TREE_FLAG_INDEX = 0x01;
+// Flag bit set when a string table follows the header and values are encoded as indices into it.
+// Only the interned storyline loader understands such files; generic decoders reject them.
+inline constexpr std::uint8_t BINARY_TREE_FLAG_STRING_TABLE = 0x02;
+// Every flag bit a reader of this version understands; files with any other bit set are rejected.
+inline constexpr std::uint8_t BINARY_TREE_KNOWN_FLAGS = BINARY_TREE_FLAG_INDEX | BINARY_TREE_FLAG_STRING_TABLE;
+
+inline constexpr char BINARY_INDEX_MAGIC[] = {'T', 'R', 'B', 'X'};
+inline constexpr std::size_t BINARY_INDEX_ENTRY_SIZE = 16;
+// indexOffset + checksum + magic
+inline constexpr std::size_t BINARY_INDEX_TRAILER_SIZE = 8 + 8 + sizeof(BINARY_INDEX_MAGIC);
+
+/**
+ * @brief Checks whether a buffer starts with the binary tree header.
+ *
+ * @param data Buffer to inspect; may be shorter than the header.
+ * @return true if the buffer begins with the binary magic bytes.
+ */
+inline bool isBinaryTree(std::string_view data) noexcept {
+    return data.size() >= BINARY_TREE_MAGIC_SIZE &&
+           data.compare(0, BINARY_TREE_MAGIC_SIZE, std::string_view(BINARY_TREE_MAGIC, BINARY_TREE_MAGIC_SIZE)) == 0;
+}
+
+/**
+ * @brief Reads the flags byte of a binary tree header.
+ *
+ * @param data Buffer starting with a binary tree header.
+ * @return std::uint8_t The BINARY_TREE_FLAG_* bits, or 0 if the header is truncated.
+ */
+inline std::uint8_t binaryTreeFlags(std::string_view data) noexcept {
+    return data.size() < BINARY_TREE_HEADER_SIZE ? 0 : static_cast<std::uint8_t>(data[BINARY_TREE_MAGIC_SIZE + 1]);
+}
+
+/**
+ * @brief Validates a binary tree header for the generic decoders.
+ *
+ * @param data Whole binary serialized tree.
+ * @return bool True if the records use chain headers (version 2), false for version 1.
+ * @throw std::invalid_argument If the header is missing, its version or flag bits are unknown,
+ *                              or the values refer to a string table.
+ */
+inline bool checkBinaryTreeHeader(std::string_view data) {
+    if (!isBinaryTree(data) || data.size() < BINARY_TREE_HEADER_SIZE) {
+        throw std::invalid_argument("Invalid binary tree: missing header");
+    }
+    auto version = static_cast<std::uint8_t>(data[BINARY_TREE_MAGIC_SIZE]);
+    if (version != BINARY_TREE_VERSION && version != BINARY_TREE_VERSION_UNCHAINED) {
+        throw std::invalid_argument("Invalid binary tree: unsupported version");
+    }
+    if (binaryTreeFlags(data) & ~BINARY_TREE_KNOWN_FLAGS) {
+        throw std::invalid_argument("Invalid binary tree: unknown flags");
+    }
+    if (binaryTreeFlags(data) & BINARY_TREE_FLAG_STRING_TABLE) {
+        throw std::invalid_argument("Invalid binary tree: values refer to a string table, which this decoder doesn't read");
+    }
+    return version == BINARY_TREE_VERSION;
+}
+
+/**
+ * @brief Appends an unsigned LEB128 varint to a buffer.
+ *
+ * @param out Buffer to append to.
+ * @param value Value to encode; 7 bits per byte, high bit set on all but the last byte.
+ */
+inline void writeVarint(std::string& out, std::uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+/**
+ * @brief Reads an unsigned LEB128 varint and advances the cursor past it.
+ *
+ * @param cursor Current read position; advanced on success.
+ * @param end One past the last readable byte.
+ * @return std::uint64_t The decoded value.
+ * @throw std::invalid_argument If the varint is truncated or longer than 64 bits.
+ */
+inline std::uint64_t readVarint(const char*& cursor, const char* end) {
+    std::uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (cursor == end) {
+            throw std::invalid_argument("Invalid binary tree: truncated varint");
+        }
+        auto byte = static_cast<std::uint8_t>(*cursor++);
+        value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return value;
+        }
+    }
+    throw std::invalid_argument("Invalid binary tree: varint exceeds 64 bits");
+}
+
+/**
+ * @brief Appends a length-prefixed byte string to a buffer.
+ *
+ * @param out Buffer to append to.
+ * @param bytes Bytes to write after their varint length.
+ */
+inline void writeLengthPrefixed(std::string& out, std::string_view bytes) {
+    writeVarint(out, bytes.size());
+    out.append(bytes.data(), bytes.size());
+}
+
+/**
+ * @brief Reads a length-prefixed byte string without copying it.
+ *
+ * The returned view points into the input buffer and is only valid as long as it is.
+ *
+ * @param cursor Current read position; advanced past the string on success.
+ * @param end One past the last readable byte.
+ * @return std::string_view View of the payload bytes.
+ * @throw std::invalid_argument If the length runs past the end of the buffer.
+ */
+inline std::string_view readLengthPrefixed(const char*& cursor, const char* end) {
+    std::uint64_t length = readVarint(cursor, end);
+    if (length > static_cast<std::uint64_t>(end - cursor)) {
+        throw std::invalid_argument("Invalid binary tree: payload runs past end of data");
+    }
+    std::string_view bytes(cursor, static_cast<std::size_t>(length));
+    cursor += length;
+    return bytes;
+}
+
+/**
+ * @brief Appends the record header of a node with `childCount` children.
+ *
+ * @param out Buffer to append to.
+ * @param childCount Number of children of the node.
+ */
+inline void writeRecordHeader(std::string& out, std::uint64_t childCount) {
+    writeVarint(out, childCount << 1);
+}
+
+/**
+ * @brief Appends the record header of a chain; the caller writes the chain's payloads after it.
+ *
+ * @param out Buffer to append to.
+ * @param length Number of nodes in the chain, each with exactly one child; at least 1.
+ */
+inline void writeChainHeader(std::string& out, std::uint64_t length) {
+    writeVarint(out, (length << 1) | 1);
+}
+
+/**
+ * @brief Reads the record headers of a sequence of nodes, expanding chain records.
+ *
+ * Without chains every node has a header holding its child count. With them,
+ * `next` reads a header only when the previous chain has run out, and
+ * reports a child count of 1 for every node inside a chain.
+ */
+class RecordHeaderReader {
+public:
+    /**
+     * @param chains Whether the headers use the chain encoding (version 2 files).
+     */
+    explicit RecordHeaderReader(bool chains) noexcept : chains(chains) {}
+
+    /**
+     * @brief Reads the next node's header, if it has one.
+     *
+     * @param cursor Current read position; advanced past a header when one is read.
+     * @param end One past the last readable byte.
+     * @return std::uint64_t The node's child count.
+     * @throw std::invalid_argument If the header is truncated or describes an empty chain.
+     */
+    std::uint64_t next(const char*& cursor, const char* end) {
+        if (chainRemaining > 0) {
+            --chainRemaining;
+            return 1;
+        }
+        std::uint64_t header = readVarint(cursor, end);
+        if (!chains) {
+            return header;
+        }
+        if (!(header & 1)) {
+            return header >> 1;
+        }
+        if (header == 1) {
+            throw std::invalid_argument("Invalid binary tree: empty chain record");
+        }
+        chainRemaining = (header >> 1) - 1;
+        return 1;
+    }
+
+private:
+    bool chains;
+    std::uint64_t chainRemaining = 0; // Nodes of the current chain not read yet
+};
+
+/**
+ * @brief Appends a fixed-width little-endian integer to a buffer.
+ *
+ * @param out Buffer to append to.
+ * @param value Value to encode.
+ * @param width Number of bytes to write, at most 8.
+ */
+inline void writeFixed(std::string& out, std::uint64_t value, std::size_t width) {
+    for (std::size_t i = 0; i < width; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+/**
+ * @brief Reads a fixed-width little-endian integer; the caller checks the bounds.
+ *
+ * @param bytes Start of the integer.
+ * @param width Number of bytes to read, at most 8.
+ * @return std::uint64_t The decoded value.
+ */
+inline std::uint64_t readFixed(const char* bytes, std::size_t width) noexcept {
+    std::uint64_t value = 0;
+    for (std::size_t i = 0; i < width; ++i) {
+        value |= static_cast<std::uint64_t>(static_cast<std::uint8_t>(bytes[i])) << (8 * i);
+    }
+    return value;
+}
+
+inline constexpr std::uint64_t FNV1A_OFFSET_BASIS = 14695981039346656037ULL;
+
+/**
+ * @brief Computes a 64-bit FNV-1a hash, optionally continuing an earlier one.
+ *
+ * @param bytes Bytes to hash.
+ * @param hash Hash of the preceding bytes, for hashing data in pieces.
+ * @return std::uint64_t The updated hash.
+ */
+inline std::uint64_t fnv1a64(std::string_view bytes, std::uint64_t hash = FNV1A_OFFSET_BASIS) noexcept {
+    for (char byte : bytes) {
+        hash ^= static_cast<std::uint8_t>(byte);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/**
+ * @brief Location of one node's record, as stored in the index footer.
+ */
+struct BinaryIndexEntry {
+    std::uint64_t offset;      // Byte position of the node's payload, or of its child count in version 1
+    std::uint32_t childCount;
+    std::uint32_t subtreeSize; // Nodes in the subtree, including the node itself
+};
+
+/**
+ * @brief Appends one index entry to a buffer.
+ *
+ * @param out Buffer to append to.
+ * @param entry Entry to encode.
+ */
+inline void writeBinaryIndexEntry(std::string& out, const BinaryIndexEntry& entry) {
+    writeFixed(out, entry.offset, 8);
+    writeFixed(out, entry.childCount, 4);
+    writeFixed(out, entry.subtreeSize, 4);
+}
+
+/**
+ * @brief Appends the footer trailer that follows the index entries.
+ *
+ * @param out Buffer to append to.
+ * @param indexOffset Byte position of the first entry.
+ * @param checksum fnv1a64 of all the encoded entries.
+ */
+inline void writeBinaryIndexTrailer(std::string& out, std::uint64_t indexOffset, std::uint64_t checksum) {
+    writeFixed(out, indexOffset, 8);
+    writeFixed(out, checksum, 8);
+    out.append(BINARY_INDEX_MAGIC, sizeof(BINARY_INDEX_MAGIC));
+}
+
+/**
+ * @brief Reads entry `nodeID` from a validated index.
+ *
+ * @param index Entries returned by `findBinaryIndex`.
+ * @param nodeID Position of the entry; must be below the entry count.
+ * @return BinaryIndexEntry The decoded entry.
+ */
+inline BinaryIndexEntry readBinaryIndexEntry(std::string_view index, std::size_t nodeID) noexcept {
+    const char* entry = index.data() + nodeID * BINARY_INDEX_ENTRY_SIZE;
+    return BinaryIndexEntry{readFixed(entry, 8),
+                            static_cast<std::uint32_t>(readFixed(entry + 8, 4)),
+                            static_cast<std::uint32_t>(readFixed(entry + 12, 4))};
+}
+
+/**
+ * @brief Locates and validates the index footer of a binary tree.
+ *
+ * @param data Whole binary serialized tree, header included.
+ * @return std::string_view The encoded entries, or an empty view if the file has no index.
+ * @throw std::invalid_argument If the index flag is set but the footer is damaged or fails its checksum.
+ */
+inline std::string_view findBinaryIndex(std::string_view data) {
+    if (!(binaryTreeFlags(data) & BINARY_TREE_FLAG_INDEX)) {
+        return std::string_view();
+    }
+    if (data.size() < BINARY_TREE_HEADER_SIZE + BINARY_INDEX_TRAILER_SIZE) {
+        throw std::invalid_argument("Invalid binary tree: index footer is truncated");
+    }
+    const char* trailer = data.data() + data.size() - BINARY_INDEX_TRAILER_SIZE;
+    if (std::string_view(trailer + 16, sizeof(BINARY_INDEX_MAGIC)) !=
+        std::string_view(BINARY_INDEX_MAGIC, sizeof(BINARY_INDEX_MAGIC))) {
+        throw std::invalid_argument("Invalid binary tree: index footer magic not found");
+    }
+    std::uint64_t indexOffset = readFixed(trailer, 8);
+    std::uint64_t indexEnd = data.size() - BINARY_INDEX_TRAILER_SIZE;
+    if (indexOffset < BINARY_TREE_HEADER_SIZE || indexOffset > indexEnd ||
+        (indexEnd - indexOffset) % BINARY_INDEX_ENTRY_SIZE != 0) {
+        throw std::invalid_argument("Invalid binary tree: index footer is out of bounds");
+    }
+    std::string_view index = data.substr(indexOffset, indexEnd - indexOffset);
+    if (fnv1a64(index) != readFixed(trailer + 8, 8)) {
+        throw std::invalid_argument("Invalid binary tree: index checksum mismatch");
+    }
+    return index;
+}
+
+// Base template for has_binary_codec; assumes T has no dedicated binary encoding.
+template <typename T, typename = void>
+struct has_binary_codec : std::false_type {};
+
+// Specialization of has_binary_codec; true if encodeBinary/decodeBinary overloads exist for T.
+template <typename T>
+struct has_binary_codec<T,
+    std::void_t<decltype(encodeBinary(std::declval<std::string&>(), std::declval<const T&>())),
+                decltype(decodeBinary(std::declval<const char*&>(), std::declval<const char*>(), std::declval<T&>()))>>
+    : std::true_type {};
+
+#endif // BINARYCODEC_H
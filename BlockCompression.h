@@ -0,0 +1,325 @@
+/**
+ * Block compression for the compressed storyline container.
+ *
+ * Serialized trees repeat the same words and field prefixes on nearly every
+ * node, which a small LZ77 coder removes cheaply. Each block is encoded as a
+ * run of sequences, all lengths being LEB128 varints:
+ *
+ *   literalLength, literal bytes, matchLength - LZ_MIN_MATCH, matchOffset
+ *
+ * where a match copies matchLength bytes starting matchOffset bytes back in
+ * the output. The last sequence stops after its literals. Matches are found
+ * with a single-probe hash table, favouring speed over ratio. Matches are
+ * capped at LZ_MAX_MATCH bytes, which bounds how far a block can expand, so
+ * readers reject a recorded block size before allocating for it.
+ *
+ *
+ * COMPRESSED REPRESENTATION
+ * _________________________
+ *
+ * "TRZ1"                 <--- 4 byte magic
+ * version  (1 byte)
+ * flags    (1 byte)
+ * nodeCount (varint)
+ * blockCount (varint)
+ * structure                        <--- one block: header, payloadSize (varints) per node, in pre-order
+ * firstNode, rawSize, compressedSize (varints), checksum (u64)   <--- one table entry per value block
+ * value blocks                     <--- the nodes' binary payloads, in pre-order, one block after another
+ *
+ * Record headers are child counts in version 1, and use the chain encoding
+ * of binary version 2 in version 2, so a chain of single-child nodes is one
+ * header followed by the payload sizes of its nodes. No flag bits are
+ * defined yet; readers reject files that set any.
+ *
+ * The structure block is stored as rawSize, compressedSize (varints),
+ * checksum (u64) and its bytes. Checksums are FNV-1a of the uncompressed
+ * bytes. Block N holds the payloads of nodes firstNode up to the next
+ * block's firstNode; since pre-order keeps every subtree contiguous, a reader
+ * only decompresses the blocks covering the nodes it needs.
+ */
+
+#ifndef BLOCKCOMPRESSION_H
+#define BLOCKCOMPRESSION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "BinaryCodec.h"
+
+inline constexpr char COMPRESSED_TREE_MAGIC[] = {'T', 'R', 'Z', '1'};
+inline constexpr std::size_t COMPRESSED_TREE_MAGIC_SIZE = sizeof(COMPRESSED_TREE_MAGIC);
+// Version written by Tree::serializeCompressed; it adds chain records to version 1
+inline constexpr std::uint8_t COMPRESSED_TREE_VERSION = 2;
+inline constexpr std::uint8_t COMPRESSED_TREE_VERSION_UNCHAINED = 1;
+// magic + version + flags
+inline constexpr std::size_t COMPRESSED_TREE_HEADER_SIZE = COMPRESSED_TREE_MAGIC_SIZE + 2;
+// Uncompressed bytes of values gathered into one block by default
+inline constexpr std::size_t COMPRESSED_TREE_BLOCK_SIZE = 64 * 1024;
+
+inline constexpr std::size_t LZ_MIN_MATCH = 4;
+// Longest match written; a 4 byte sequence (empty literals, 2 byte length, offset) yields at most this many bytes
+inline constexpr std::size_t LZ_MAX_MATCH = 1024;
+// Bound on decompressed / compressed size that follows from LZ_MAX_MATCH, checked before allocating
+inline constexpr std::size_t LZ_MAX_EXPANSION = LZ_MAX_MATCH / 4;
+inline constexpr unsigned LZ_HASH_BITS = 14;
+
+/**
+ * @brief Checks whether a buffer starts with the compressed container header.
+ *
+ * @param data Buffer to inspect; may be shorter than the header.
+ * @return true if the buffer begins with the compressed magic bytes.
+ */
+inline bool isCompressedTree(std::string_view data) noexcept {
+    return data.size() >= COMPRESSED_TREE_MAGIC_SIZE &&
+           data.compare(0, COMPRESSED_TREE_MAGIC_SIZE,
+                        std::string_view(COMPRESSED_TREE_MAGIC, COMPRESSED_TREE_MAGIC_SIZE)) == 0;
+}
+
+/**
+ * @brief Compresses one block and appends it to a buffer.
+ *
+ * @param out Buffer to append to.
+ * @param raw Bytes to compress.
+ */
+inline void compressBlock(std::string& out, std::string_view raw) {
+    const char* base = raw.data();
+    const std::size_t size = raw.size();
+    // last position + 1 at which each 4-byte hash was seen; 0 means never
+    std::vector<std::uint32_t> seen(std::size_t(1) << LZ_HASH_BITS, 0);
+
+    std::size_t literalStart = 0;
+    std::size_t position = 0;
+    std::size_t misses = 0;
+    while (position + LZ_MIN_MATCH <= size) {
+        std::uint32_t word;
+        std::memcpy(&word, base + position, sizeof(word));
+        std::uint32_t hash = (word * 2654435761u) >> (32 - LZ_HASH_BITS);
+        std::size_t candidate = seen[hash];
+        seen[hash] = static_cast<std::uint32_t>(position + 1);
+
+        if (candidate == 0 || std::memcmp(base + candidate - 1, base + position, LZ_MIN_MATCH) != 0) {
+            // step faster through data that isn't compressing
+            position += 1 + (misses++ >> 5);
+            continue;
+        }
+        misses = 0;
+        std::size_t match = candidate - 1;
+        std::size_t length = LZ_MIN_MATCH;
+        while (position + length < size && length < LZ_MAX_MATCH && base[match + length] == base[position + length]) {
+            ++length;
+        }
+        writeLengthPrefixed(out, raw.substr(literalStart, position - literalStart));
+        writeVarint(out, length - LZ_MIN_MATCH);
+        writeVarint(out, position - match);
+        // remember the positions the match covered, so later text can match into it
+        for (std::size_t next = position + 1; next < position + length && next + LZ_MIN_MATCH <= size; ++next) {
+            std::memcpy(&word, base + next, sizeof(word));
+            seen[(word * 2654435761u) >> (32 - LZ_HASH_BITS)] = static_cast<std::uint32_t>(next + 1);
+        }
+        position += length;
+        literalStart = position;
+    }
+    writeLengthPrefixed(out, raw.substr(literalStart));
+}
+
+/**
+ * @brief Decompresses one block written by `compressBlock`.
+ *
+ * @param compressed The compressed bytes, exactly one block.
+ * @param rawSize Size of the block before compression, as recorded in the container.
+ * @param out Replaced by the decompressed bytes; its capacity is reused.
+ * @throw std::invalid_argument If the block is truncated, refers outside itself or claims a size
+ *        its compressed bytes could not expand to.
+ */
+inline void decompressBlock(std::string_view compressed, std::uint64_t rawSize, std::string& out) {
+    // rawSize comes from the file, so bound it before allocating
+    if (rawSize / LZ_MAX_EXPANSION > compressed.size()) {
+        throw std::invalid_argument("Invalid compressed block: block size exceeds what its data can expand to");
+    }
+    out.resize(static_cast<std::size_t>(rawSize));
+    char* output = out.data();
+    std::size_t written = 0;
+    const char* cursor = compressed.data();
+    const char* end = cursor + compressed.size();
+    while (true) {
+        std::string_view literals = readLengthPrefixed(cursor, end);
+        if (literals.size() > rawSize - written) {
+            throw std::invalid_argument("Invalid compressed block: literals run past the block size");
+        }
+        std::memcpy(output + written, literals.data(), literals.size());
+        written += literals.size();
+        if (written == rawSize && cursor == end) {
+            return;
+        }
+
+        std::uint64_t length = readVarint(cursor, end) + LZ_MIN_MATCH;
+        std::uint64_t offset = readVarint(cursor, end);
+        if (offset == 0 || offset > written || length > rawSize - written) {
+            throw std::invalid_argument("Invalid compressed block: match runs outside the block");
+        }
+        const char* source = output + written - offset;
+        if (offset >= length) {
+            std::memcpy(output + written, source, length);
+        } else {
+            // overlapping match repeats the last `offset` bytes
+            for (std::uint64_t i = 0; i < length; ++i) {
+                output[written + i] = source[i];
+            }
+        }
+        written += length;
+    }
+}
+
+/**
+ * @brief One independently compressed block of node values.
+ */
+struct CompressedBlock {
+    std::uint64_t firstNode;      // Pre-order ID of the first node whose value is in the block
+    std::uint64_t rawSize;        // Bytes once decompressed
+    std::uint64_t compressedSize; // Bytes stored
+    std::uint64_t checksum;       // FNV-1a of the decompressed bytes
+    std::size_t offset;           // Where the block's bytes start in the container
+};
+
+/**
+ * @brief Appends a block's table entry, or the structure block's prefix without firstNode.
+ */
+inline void writeCompressedBlockHeader(std::string& out, const CompressedBlock& block, bool withFirstNode) {
+    if (withFirstNode) {
+        writeVarint(out, block.firstNode);
+    }
+    writeVarint(out, block.rawSize);
+    writeVarint(out, block.compressedSize);
+    writeFixed(out, block.checksum, 8);
+}
+
+/**
+ * @brief Decompresses a block of a container and verifies its checksum.
+ *
+ * @param data Whole container.
+ * @param block Block to decompress, as listed in the container's layout.
+ * @param out Replaced by the decompressed bytes.
+ * @throw std::invalid_argument If the block is damaged.
+ */
+inline void readCompressedBlock(std::string_view data, const CompressedBlock& block, std::string& out) {
+    decompressBlock(data.substr(block.offset, static_cast<std::size_t>(block.compressedSize)), block.rawSize, out);
+    if (fnv1a64(out) != block.checksum) {
+        throw std::invalid_argument("Invalid compressed tree: block checksum mismatch");
+    }
+}
+
+/**
+ * @brief Everything needed to read a container except the value blocks themselves.
+ */
+struct CompressedTreeLayout {
+    std::uint64_t nodeCount = 0;
+    bool chains = false;   // Structure block uses chain records
+    std::string structure; // Decompressed structure block: header, payloadSize per node
+    std::vector<CompressedBlock> blocks;
+};
+
+/**
+ * @brief Reads a container's header and block table and decompresses its structure block.
+ *
+ * @param data Whole container, header included.
+ * @return CompressedTreeLayout The validated layout.
+ * @throw std::invalid_argument If the header, structure or block table is damaged.
+ */
+inline CompressedTreeLayout readCompressedLayout(std::string_view data) {
+    if (!isCompressedTree(data) || data.size() < COMPRESSED_TREE_HEADER_SIZE) {
+        throw std::invalid_argument("Invalid compressed tree: missing header");
+    }
+    auto version = static_cast<std::uint8_t>(data[COMPRESSED_TREE_MAGIC_SIZE]);
+    if (version != COMPRESSED_TREE_VERSION && version != COMPRESSED_TREE_VERSION_UNCHAINED) {
+        throw std::invalid_argument("Invalid compressed tree: unsupported version");
+    }
+    if (data[COMPRESSED_TREE_MAGIC_SIZE + 1] != 0) {
+        throw std::invalid_argument("Invalid compressed tree: unknown flags");
+    }
+    const char* begin = data.data();
+    const char* end = begin + data.size();
+    const char* cursor = begin + COMPRESSED_TREE_HEADER_SIZE;
+
+    CompressedTreeLayout layout;
+    layout.chains = version == COMPRESSED_TREE_VERSION;
+    layout.nodeCount = readVarint(cursor, end);
+    std::uint64_t blockCount = readVarint(cursor, end);
+    // a block table entry takes at least 11 bytes
+    if (blockCount > static_cast<std::uint64_t>(end - cursor) / 11) {
+        throw std::invalid_argument("Invalid compressed tree: block count exceeds data size");
+    }
+
+    auto readBlockHeader = [&](CompressedBlock& block) {
+        block.rawSize = readVarint(cursor, end);
+        block.compressedSize = readVarint(cursor, end);
+        if (end - cursor < 8) {
+            throw std::invalid_argument("Invalid compressed tree: truncated block table");
+        }
+        block.checksum = readFixed(cursor, 8);
+        cursor += 8;
+    };
+
+    CompressedBlock structure{0, 0, 0, 0, 0};
+    readBlockHeader(structure);
+    if (structure.compressedSize > static_cast<std::uint64_t>(end - cursor)) {
+        throw std::invalid_argument("Invalid compressed tree: structure runs past end of data");
+    }
+    // every node takes at least two bytes of structure, or one inside a chain
+    if (layout.nodeCount > structure.rawSize / (layout.chains ? 1 : 2)) {
+        throw std::invalid_argument("Invalid compressed tree: structure is too small for the node count");
+    }
+    structure.offset = static_cast<std::size_t>(cursor - begin);
+    readCompressedBlock(data, structure, layout.structure);
+    cursor += structure.compressedSize;
+
+    layout.blocks.reserve(blockCount);
+    for (std::uint64_t i = 0; i < blockCount; ++i) {
+        CompressedBlock block{readVarint(cursor, end), 0, 0, 0, 0};
+        readBlockHeader(block);
+        if ((i == 0 && block.firstNode != 0) || (i > 0 && block.firstNode <= layout.blocks.back().firstNode) ||
+            block.firstNode >= layout.nodeCount) {
+            throw std::invalid_argument("Invalid compressed tree: block table is out of order");
+        }
+        layout.blocks.push_back(block);
+    }
+    if (layout.nodeCount > 0 && layout.blocks.empty()) {
+        throw std::invalid_argument("Invalid compressed tree: nodes without value blocks");
+    }
+
+    // a value block holds exactly the payloads of its nodes, whatever block size it was written with
+    const char* structureCursor = layout.structure.data();
+    const char* structureEnd = structureCursor + layout.structure.size();
+    RecordHeaderReader headers(layout.chains);
+    for (std::size_t i = 0; i < layout.blocks.size(); ++i) {
+        std::uint64_t last = i + 1 < layout.blocks.size() ? layout.blocks[i + 1].firstNode : layout.nodeCount;
+        std::uint64_t payloads = 0;
+        for (std::uint64_t node = layout.blocks[i].firstNode; node < last; ++node) {
+            headers.next(structureCursor, structureEnd);
+            std::uint64_t payloadSize = readVarint(structureCursor, structureEnd);
+            if (payloadSize > layout.blocks[i].rawSize - payloads) {
+                throw std::invalid_argument("Invalid compressed tree: block size does not match its values");
+            }
+            payloads += payloadSize;
+        }
+        if (payloads != layout.blocks[i].rawSize) {
+            throw std::invalid_argument("Invalid compressed tree: block size does not match its values");
+        }
+    }
+
+    std::size_t offset = static_cast<std::size_t>(cursor - begin);
+    for (auto& block : layout.blocks) {
+        if (block.compressedSize > data.size() - offset) {
+            throw std::invalid_argument("Invalid compressed tree: block runs past end of data");
+        }
+        block.offset = offset;
+        offset += static_cast<std::size_t>(block.compressedSize);
+    }
+    return layout;
+}
+
+#endif // BLOCKCOMPRESSION_H
\ No newline at end of file
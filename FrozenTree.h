@@ -0,0 +1,381 @@
+/**
+ * An immutable, compacted snapshot of a Tree, produced by Tree::freeze().
+ *
+ * Nodes are laid out in pre-order and their structural metadata is kept in
+ * tightly packed parallel arrays, separate from the (much bulkier) values:
+ *
+ *
+ * FROZEN REPRESENTATION
+ * _____________________
+ *
+ *      1                 index:        0  1  2  3  4  5  6  7
+ *     /|\                value:        1  2  5  6  3  7  8  4
+ *    2 3 4               parent:       -  0  1  1  0  4  4  0
+ *   /| |\                childCount:   3  2  0  0  2  0  0  0
+ *  5 6 7 8               subtreeSize:  8  3  1  1  3  1  1  1
+ *
+ *
+ * A node's first child is always the next index, and its next sibling is
+ * `index + subtreeSize[index]`, so walking children or a whole subtree reads
+ * a few adjacent entries of three small arrays instead of chasing one heap
+ * object per node. A subtree is the contiguous index range
+ * [index, index + subtreeSize[index]).
+ *
+ * IDs in a FrozenTree are pre-order positions. For a tree that was just
+ * deserialized these are the same IDs the Tree used.
+ */
+
+#ifndef FROZENTREE_H
+#define FROZENTREE_H
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <stack>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "Tree.h"
+
+/**
+ * @brief Read-only, cache-friendly snapshot of a Tree.
+ *
+ * All member functions are const and the snapshot never changes after
+ * construction, so one instance can be shared freely between threads.
+ *
+ * @tparam T Data type of the node values.
+ */
+template <typename T>
+class FrozenTree {
+public:
+    /**
+     * @brief A node's ID together with read-only access to its value.
+     */
+    struct NodeRef {
+        int id;
+        const T& value;
+    };
+
+    /**
+     * @brief Forward range over a node's children, hopping from sibling to sibling.
+     */
+    class ChildRange {
+    public:
+        class iterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = NodeRef;
+            using difference_type = std::ptrdiff_t;
+            using pointer = void;
+            using reference = NodeRef;
+
+            iterator() = default;
+            iterator(const FrozenTree* tree, int nodeID, int remaining) noexcept
+                : tree(tree), nodeID(nodeID), remaining(remaining) {}
+
+            NodeRef operator*() const noexcept { return NodeRef{nodeID, tree->values[nodeID]}; }
+            iterator& operator++() noexcept {
+                nodeID += tree->subtreeSizes[nodeID];
+                --remaining;
+                return *this;
+            }
+            iterator operator++(int) noexcept { iterator copy = *this; ++*this; return copy; }
+            bool operator==(const iterator& other) const noexcept { return remaining == other.remaining; }
+            bool operator!=(const iterator& other) const noexcept { return remaining != other.remaining; }
+
+        private:
+            const FrozenTree* tree = nullptr;
+            int nodeID = 0;
+            int remaining = 0; // children left to visit, including the current one
+        };
+
+        ChildRange(const FrozenTree* tree, int nodeID) noexcept : tree(tree), nodeID(nodeID) {}
+
+        iterator begin() const noexcept { return iterator(tree, nodeID + 1, tree->childCounts[nodeID]); }
+        iterator end() const noexcept { return iterator(tree, 0, 0); }
+        size_t size() const noexcept { return static_cast<size_t>(tree->childCounts[nodeID]); }
+        bool empty() const noexcept { return tree->childCounts[nodeID] == 0; }
+
+    private:
+        const FrozenTree* tree;
+        int nodeID;
+    };
+
+    /**
+     * @brief Initializes an empty snapshot.
+     */
+    FrozenTree() = default;
+
+    /**
+     * @brief Builds a snapshot by copying a tree's values.
+     *
+     * @param tree Tree to snapshot; left unchanged.
+     */
+    explicit FrozenTree(const Tree<T>& tree) {
+        build(tree, [](const T& value) -> const T& { return value; });
+    }
+
+    /**
+     * @brief Builds a snapshot by moving a tree's values out of it.
+     *
+     * @param tree Tree to snapshot; left empty afterwards.
+     */
+    explicit FrozenTree(Tree<T>&& tree) {
+        build(tree, [](T& value) -> T&& { return std::move(value); });
+        storage = std::move(tree.storage);
+        tree = Tree<T>();
+    }
+
+    /**
+     * @brief Gets the root node's ID.
+     *
+     * @return int 0, or -1 if the snapshot is empty.
+     */
+    int getRootID() const noexcept {
+        return values.empty() ? -1 : 0;
+    }
+
+    /**
+     * @brief Number of nodes in the snapshot.
+     */
+    size_t size() const noexcept {
+        return values.size();
+    }
+
+    /**
+     * @brief Gets a node's parent.
+     *
+     * @param nodeID ID of the node.
+     * @return int ID of the parent, or -1 for the root.
+     * @throw std::invalid_argument If node ID is invalid.
+     */
+    int getParentID(int nodeID) const {
+        return parents[checkedID(nodeID)];
+    }
+
+    /**
+     * @brief Counts a node's children.
+     *
+     * @param nodeID ID of the node.
+     * @return size_t Number of children.
+     * @throw std::invalid_argument If node ID is invalid.
+     */
+    size_t childCount(int nodeID) const {
+        return static_cast<size_t>(childCounts[checkedID(nodeID)]);
+    }
+
+    /**
+     * @brief Counts the nodes in a node's subtree, including the node itself.
+     *
+     * The subtree occupies IDs [nodeID, nodeID + subtreeSize(nodeID)).
+     *
+     * @param nodeID ID of the subtree's root.
+     * @return size_t Number of nodes in the subtree.
+     * @throw std::invalid_argument If node ID is invalid.
+     */
+    size_t subtreeSize(int nodeID) const {
+        return static_cast<size_t>(subtreeSizes[checkedID(nodeID)]);
+    }
+
+    /**
+     * @brief Iterates over a node's children without allocating.
+     *
+     * @param nodeID ID of the node.
+     * @return ChildRange The node's children, in order.
+     * @throw std::invalid_argument If node ID is invalid.
+     */
+    ChildRange children(int nodeID) const {
+        return ChildRange(this, checkedID(nodeID));
+    }
+
+    /**
+     * @brief Lists a node's children IDs.
+     *
+     * @param nodeID ID of the node.
+     * @return std::vector<int> IDs of the node's children.
+     * @throw std::invalid_argument If node ID is invalid.
+     */
+    std::vector<int> getChildrenIDs(int nodeID) const {
+        std::vector<int> childrenIDs;
+        childrenIDs.reserve(childCount(nodeID));
+        for (auto child : children(nodeID)) {
+            childrenIDs.push_back(child.id);
+        }
+        return childrenIDs;
+    }
+
+    /**
+     * @brief Retrieves a node's value.
+     *
+     * @param nodeID ID for value retrieval.
+     * @return T const& The node's value.
+     * @throw std::invalid_argument If node ID is invalid.
+     */
+    const T& getValue(int nodeID) const {
+        return values[checkedID(nodeID)];
+    }
+
+    /**
+     * @brief Accesses a node's value by ID. Equivalent to `getValue`.
+     *
+     * @param nodeID ID of the node.
+     * @return T const& Value of the node.
+     * @throw std::invalid_argument If node is missing.
+     */
+    const T& operator[](int nodeID) const {
+        return values[checkedID(nodeID)];
+    }
+
+    /**
+     * @brief Rebuilds a mutable Tree with the same structure and values.
+     *
+     * The new tree's IDs are the snapshot's pre-order IDs.
+     *
+     * @return Tree<T> A tree holding copies of the values.
+     */
+    Tree<T> thaw() const& {
+        Tree<T> tree = Tree<T>::fromLinearized(linearize(*this, [](const T& value) -> const T& { return value; }));
+        tree.retainStorage(storage);
+        return tree;
+    }
+
+    /**
+     * @brief Rebuilds a mutable Tree, moving the values out of this snapshot.
+     *
+     * @return Tree<T> A tree holding the snapshot's values; the snapshot is left empty.
+     */
+    Tree<T> thaw() && {
+        Tree<T> tree = Tree<T>::fromLinearized(linearize(*this, [](T& value) -> T&& { return std::move(value); }));
+        tree.retainStorage(std::move(storage));
+        *this = FrozenTree<T>();
+        return tree;
+    }
+
+private:
+    // Hot metadata, one entry per node in pre-order
+    std::vector<int> parents;
+    std::vector<int> childCounts;
+    std::vector<int> subtreeSizes;
+    // Cold payload, same order
+    std::vector<T> values;
+    std::shared_ptr<const void> storage; // Buffer the values may refer into, carried over from the Tree
+
+    int checkedID(int nodeID) const {
+        if (nodeID < 0 || static_cast<size_t>(nodeID) >= values.size()) {
+            std::stringstream errMsg;
+            errMsg << "Node with ID " << nodeID << " does not exist";
+            throw std::invalid_argument(errMsg.str());
+        }
+        return nodeID;
+    }
+
+    /**
+     * @brief Fills the arrays from a pre-order walk of a tree.
+     *
+     * @param tree Source tree.
+     * @param take Returns the value to store for a node (a copy or a move).
+     */
+    template <typename TreeType, typename Take>
+    void build(TreeType& tree, Take take) {
+        storage = tree.storage;
+        parents.reserve(tree.liveNodeCount);
+        childCounts.reserve(tree.liveNodeCount);
+        subtreeSizes.assign(tree.liveNodeCount, 1);
+        values.reserve(tree.liveNodeCount);
+
+        // stack of (node, index of its parent)
+        std::stack<std::pair<decltype(tree.root.get()), int>> stack;
+        if (tree.root) {
+            stack.push({tree.root.get(), -1});
+        }
+        while (!stack.empty()) {
+            auto [node, parent] = stack.top();
+            stack.pop();
+
+            int index = static_cast<int>(values.size());
+            parents.push_back(parent);
+            childCounts.push_back(static_cast<int>(node->children.size()));
+            values.push_back(take(node->value));
+            for (auto itr = node->children.rbegin(); itr != node->children.rend(); ++itr) {
+                stack.push({itr->get(), index});
+            }
+        }
+
+        // children follow their parent in pre-order, so one backwards pass sums the subtree sizes
+        for (size_t index = values.size(); index-- > 1;) {
+            subtreeSizes[parents[index]] += subtreeSizes[index];
+        }
+    }
+
+    /**
+     * @brief Produces the linearized representation used to rebuild a Tree.
+     *
+     * @param self Snapshot to read; const when copying values, mutable when moving them.
+     * @param take Returns the value to emit for a node (a copy or a move).
+     * @return std::vector<std::optional<T>> Pre-order values with end-of-children tokens.
+     */
+    template <typename Self, typename Take>
+    static std::vector<std::optional<T>> linearize(Self& self, Take take) {
+        std::vector<std::optional<T>> linearized;
+        linearized.reserve(self.values.size() * 2);
+        // end index of each open subtree; a node closes when the walk reaches its end
+        std::vector<size_t> openEnds;
+        for (size_t index = 0; index < self.values.size(); ++index) {
+            while (!openEnds.empty() && openEnds.back() == index) {
+                openEnds.pop_back();
+                linearized.push_back(std::nullopt);
+            }
+            linearized.push_back(take(self.values[index]));
+            openEnds.push_back(index + static_cast<size_t>(self.subtreeSizes[index]));
+        }
+        linearized.insert(linearized.end(), openEnds.size(), std::nullopt);
+        return linearized;
+    }
+};
+
+/**
+ * @brief Maps every node of one snapshot to the same node in another, where it is unchanged.
+ *
+ * Used to carry positions over when a newer version of a tree replaces an
+ * older one. The roots correspond if their values are equal; below that, a
+ * node corresponds to a child of its parent's counterpart with an equal value.
+ * Siblings are matched in order, so adding, removing or editing one choice
+ * doesn't disturb the matches of the others. A node whose value or any
+ * ancestor's value changed has no counterpart.
+ *
+ * @param from Snapshot whose IDs are mapped.
+ * @param to Snapshot the IDs are mapped into.
+ * @return std::vector<int> For each ID in `from`, the matching ID in `to`, or -1.
+ */
+template <typename T>
+std::vector<int> mapUnchangedNodes(const FrozenTree<T>& from, const FrozenTree<T>& to) {
+    std::vector<int> mapping(from.size(), -1);
+    if (from.size() == 0 || to.size() == 0 || !(from[0] == to[0])) {
+        return mapping;
+    }
+    mapping[0] = 0;
+    std::vector<int> candidates;
+    // parents precede their children in pre-order, so every parent is mapped before its children are
+    for (size_t id = 0; id < from.size(); ++id) {
+        if (mapping[id] == -1 || from.childCount(static_cast<int>(id)) == 0) {
+            continue;
+        }
+        candidates = to.getChildrenIDs(mapping[id]);
+        size_t next = 0; // first candidate not yet matched or skipped
+        for (auto child : from.children(static_cast<int>(id))) {
+            for (size_t i = next; i < candidates.size(); ++i) {
+                if (child.value == to[candidates[i]]) {
+                    mapping[child.id] = candidates[i];
+                    next = i + 1;
+                    break;
+                }
+            }
+        }
+    }
+    return mapping;
+}
+
+#endif // FROZENTREE_H
\ No newline at end of file
@@ -0,0 +1,507 @@
+/**
+ * A read-only view of a serialized tree that decodes node values on demand.
+ *
+ * Opening a LazyTree makes one structural pass over the serialized data and
+ * records, for every node, where its value starts, how many children it has
+ * and how many nodes its subtree spans. No value is parsed during that pass.
+ * A value is decoded the first time it is asked for, and a bounded LRU cache
+ * keeps the most recently used ones resident, so memory use follows the part
+ * of the story that is actually visited rather than the size of the file.
+ *
+ *
+ * OFFSET INDEX
+ * ____________
+ *
+ *      1                 ID:           0  1  2  3  4  5  6  7
+ *     /|\                offset:       o0 o1 o2 o3 o4 o5 o6 o7   <--- byte offset of the value
+ *    2 3 4               childCount:   3  2  0  0  2  0  0  0
+ *   /| |\                subtreeSize:  8  3  1  1  3  1  1  1
+ *  5 6 7 8
+ *
+ *
+ * IDs are pre-order positions, which are the same IDs Tree::serialize writes
+ * and Tree::deserialize assigns. As in FrozenTree, a node's first child is the
+ * next ID and its next sibling is `ID + subtreeSize[ID]`.
+ *
+ * Binary files written with an index footer (see BinaryCodec.h) already hold
+ * this index, so opening them only validates the footer's checksum and reads
+ * entries straight from the file; nothing is scanned or copied.
+ *
+ * Compressed containers (see BlockCompression.h) are indexed from their
+ * structure block alone; a value block is decompressed only when one of its
+ * values is decoded, and the most recently used block is kept for the next
+ * access, which is usually a nearby node of the same subtree.
+ */
+
+#ifndef LAZYTREE_H
+#define LAZYTREE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "BinaryCodec.h"
+#include "BlockCompression.h"
+#include "LineScanner.h"
+#include "Tree.h"
+
+/**
+ * @brief Read-only tree over serialized data, decoding values when first accessed.
+ *
+ * Accepts the text and binary serializations and the compressed container. The data must outlive
+ * the tree; pass the owning buffer (e.g. a MappedFile) as `storage` to tie
+ * their lifetimes together.
+ *
+ * @attention Not thread-safe, even for reads: value accesses update the cache.
+ *
+ * @tparam T Data type of the node values; same requirements as for Tree.
+ */
+template <typename T>
+class LazyTree {
+public:
+    /**
+     * @brief Initializes an empty tree.
+     */
+    LazyTree() = default;
+
+    /**
+     * @brief Indexes serialized tree data without decoding any values.
+     *
+     * @param serialized Text, binary or compressed serialization; must stay valid while the tree is used.
+     * @param cacheCapacity Maximum number of decoded values kept resident; 0 disables caching.
+     * @param storage Buffer owning `serialized`, kept alive by the tree.
+     * @throw std::invalid_argument If the serialization is malformed.
+     */
+    LazyTree(std::string_view serialized, size_t cacheCapacity, std::shared_ptr<const void> storage = nullptr)
+        : serialized(serialized), capacity(cacheCapacity), binary(isBinaryTree(serialized)),
+          compressed(isCompressedTree(serialized)), storage(std::move(storage)) {
+        Tree<T>::T_compatible_check();
+        if (compressed) {
+            indexCompressed();
+        } else if (binary) {
+            indexBinary();
+        } else {
+            indexText();
+        }
+    }
+
+    // The cache holds iterators into its own list, which a copy would keep pointing at the source's
+    LazyTree(const LazyTree&) = delete;
+    LazyTree& operator=(const LazyTree&) = delete;
+
+    /**
+     * @brief Takes over another tree's index and cache; std::list iterators stay valid across the move.
+     */
+    LazyTree(LazyTree&&) = default;
+    LazyTree& operator=(LazyTree&&) = default;
+
+    /**
+     * @brief Gets the root node's ID.
+     *
+     * @return int 0, or -1 if the tree is empty.
+     */
+    int getRootID() const noexcept {
+        return nodeCount == 0 ? -1 : 0;
+    }
+
+    /**
+     * @brief Number of nodes in the tree.
+     */
+    size_t size() const noexcept {
+        return nodeCount;
+    }
+
+    /**
+     * @brief Counts a node's children without decoding anything.
+     *
+     * @param nodeID ID of the node.
+     * @return size_t Number of children.
+     * @throw std::invalid_argument If node ID is invalid.
+     */
+    size_t childCount(int nodeID) const {
+        return entry(checkedID(nodeID)).childCount;
+    }
+
+    /**
+     * @brief Lists a node's children IDs without decoding anything.
+     *
+     * @param nodeID ID of the node.
+     * @return std::vector<int> IDs of the node's children.
+     * @throw std::invalid_argument If node ID is invalid.
+     */
+    std::vector<int> getChildrenIDs(int nodeID) const {
+        size_t count = childCount(nodeID);
+        std::vector<int> childrenIDs;
+        childrenIDs.reserve(count);
+        int child = nodeID + 1;
+        for (size_t i = 0; i < count; ++i) {
+            childrenIDs.push_back(checkedID(child));
+            child += static_cast<int>(entry(child).subtreeSize);
+        }
+        return childrenIDs;
+    }
+
+    /**
+     * @brief Retrieves a node's value, decoding it if it isn't resident.
+     *
+     * Returns a copy, since a cached value may be evicted by later accesses.
+     *
+     * @param nodeID ID for value retrieval.
+     * @return T The node's value.
+     * @throw std::invalid_argument If node ID is invalid or its value cannot be parsed.
+     */
+    T getValue(int nodeID) const {
+        checkedID(nodeID);
+        auto found = resident.find(nodeID);
+        if (found != resident.end()) {
+            // mark as most recently used
+            recent.splice(recent.begin(), recent, found->second.second);
+            return found->second.first;
+        }
+
+        T value;
+        decode(nodeID, value);
+        if (capacity == 0) {
+            return value;
+        }
+        if (resident.size() >= capacity) {
+            resident.erase(recent.back());
+            recent.pop_back();
+        }
+        recent.push_front(nodeID);
+        resident.emplace(nodeID, std::make_pair(value, recent.begin()));
+        return value;
+    }
+
+    /**
+     * @brief Accesses a node's value by ID. Equivalent to `getValue`.
+     *
+     * @param nodeID ID of the node.
+     * @return T Value of the node.
+     * @throw std::invalid_argument If node is missing or its value cannot be parsed.
+     */
+    T operator[](int nodeID) const {
+        return getValue(nodeID);
+    }
+
+    /**
+     * @brief Counts the nodes in a node's subtree, including the node itself.
+     *
+     * @param nodeID ID of the subtree's root.
+     * @return size_t Number of nodes in the subtree.
+     * @throw std::invalid_argument If node ID is invalid.
+     */
+    size_t subtreeSize(int nodeID) const {
+        return entry(checkedID(nodeID)).subtreeSize;
+    }
+
+    /**
+     * @brief Decodes one subtree into a standalone Tree, bypassing the cache.
+     *
+     * The subtree's root becomes the new tree's root, and IDs are renumbered
+     * in pre-order from 0.
+     *
+     * @param nodeID ID of the subtree's root.
+     * @return Tree<T> A tree holding the subtree's values.
+     * @throw std::invalid_argument If node ID is invalid or a value cannot be parsed.
+     */
+    Tree<T> extractSubtree(int nodeID) const {
+        size_t first = static_cast<size_t>(checkedID(nodeID));
+        size_t last = first + entry(nodeID).subtreeSize;
+        if (last > nodeCount) {
+            throw std::invalid_argument("Invalid tree index: subtree runs past the last node");
+        }
+        std::vector<std::optional<T>> linearized;
+        linearized.reserve((last - first) * 2);
+        // end of each open subtree; a node closes when the walk reaches its end
+        std::vector<size_t> openEnds;
+        for (size_t id = first; id < last; ++id) {
+            while (!openEnds.empty() && openEnds.back() == id) {
+                openEnds.pop_back();
+                linearized.push_back(std::nullopt);
+            }
+            T value;
+            decode(static_cast<int>(id), value);
+            linearized.push_back(std::move(value));
+            openEnds.push_back(id + entry(static_cast<int>(id)).subtreeSize);
+        }
+        linearized.insert(linearized.end(), openEnds.size(), std::nullopt);
+        return Tree<T>::fromLinearized(std::move(linearized));
+    }
+
+    /**
+     * @brief Whether the index was read from the file's footer rather than rebuilt.
+     */
+    bool hasPersistedIndex() const noexcept {
+        return !persistedIndex.empty();
+    }
+
+    /**
+     * @brief Number of decoded values currently held in the cache.
+     */
+    size_t residentCount() const noexcept {
+        return resident.size();
+    }
+
+    /**
+     * @brief Drops every cached value; the index is kept.
+     */
+    void clearCache() const noexcept {
+        resident.clear();
+        recent.clear();
+    }
+
+private:
+    std::string_view serialized;
+    size_t capacity = 0;
+    bool binary = false;
+    bool compressed = false;
+    std::shared_ptr<const void> storage; // Keeps the serialized buffer alive
+
+    // Structural index, one entry per node in pre-order. Offsets point at the
+    // value text, at the payload of a binary record (or its child count, in a
+    // version 1 footer), or at the value's payload within its decompressed
+    // block.
+    size_t nodeCount = 0;
+    std::vector<BinaryIndexEntry> entries; // Built while opening
+    std::string_view persistedIndex;       // Or read from the footer in place
+    bool offsetsAtHeaders = false;         // Binary offsets point at child counts rather than payloads
+
+    // Value blocks of a compressed container, and the one currently decompressed
+    std::vector<CompressedBlock> blocks;
+    mutable std::string blockData;
+    mutable size_t loadedBlock = static_cast<size_t>(-1);
+
+    // LRU cache of decoded values; `recent` is ordered most recently used first
+    mutable std::list<int> recent;
+    mutable std::unordered_map<int, std::pair<T, std::list<int>::iterator>> resident;
+
+    int checkedID(int nodeID) const {
+        if (nodeID < 0 || static_cast<size_t>(nodeID) >= nodeCount) {
+            std::stringstream errMsg;
+            errMsg << "Node with ID " << nodeID << " does not exist";
+            throw std::invalid_argument(errMsg.str());
+        }
+        return nodeID;
+    }
+
+    BinaryIndexEntry entry(int nodeID) const noexcept {
+        return persistedIndex.empty() ? entries[nodeID] : readBinaryIndexEntry(persistedIndex, static_cast<size_t>(nodeID));
+    }
+
+    // Adds a node to the index as a child of the innermost open node.
+    void openNode(size_t offset, std::vector<int>& open) {
+        if (!entries.empty() && open.empty()) {
+            throw std::invalid_argument("Invalid tree serialization: nodes found after the root's subtree ended");
+        }
+        if (!open.empty()) {
+            entries[open.back()].childCount++;
+        }
+        open.push_back(static_cast<int>(entries.size()));
+        entries.push_back(BinaryIndexEntry{offset, 0, 0});
+        nodeCount = entries.size();
+    }
+
+    // Closes the innermost open node, whose subtree ends at the current node count.
+    void closeNode(std::vector<int>& open) {
+        entries[open.back()].subtreeSize = static_cast<std::uint32_t>(entries.size() - static_cast<size_t>(open.back()));
+        open.pop_back();
+    }
+
+    /**
+     * @brief Builds the index from the text serialization by classifying lines only.
+     *
+     * @throw std::invalid_argument If a line is malformed or the end-of-children tokens don't balance.
+     */
+    void indexText() {
+        LineScanner scanner(serialized);
+        std::vector<LineRecord> records;
+        std::vector<int> open;
+        while (scanner.scan(records)) {
+            for (const auto& record : records) {
+                if (record.kind == LineRecord::NodeValue) {
+                    openNode(static_cast<size_t>(record.line.data() - serialized.data()) + record.valueOffset, open);
+                } else if (record.kind == LineRecord::EndOfChildren) {
+                    if (record.count > open.size()) {
+                        throw std::invalid_argument("Invalid tree serialization: too many end-of-children tokens");
+                    }
+                    for (size_t i = 0; i < record.count; ++i) {
+                        closeNode(open);
+                    }
+                } else {
+                    throw std::invalid_argument("Invalid tree serialization: invalid line format: " + std::string(record.line));
+                }
+            }
+        }
+        if (!open.empty()) {
+            throw std::invalid_argument("Invalid tree serialization: Too few end-of-children tokens");
+        }
+    }
+
+    /**
+     * @brief Builds the index from the binary serialization.
+     *
+     * Uses the index footer when the file has one. Otherwise the records are
+     * walked; payloads have a type-defined layout, so each one is decoded into
+     * a scratch value to find where it ends, and nothing is kept resident.
+     *
+     * @throw std::invalid_argument If the data is truncated, the child counts don't add up,
+     *                              or the index footer fails validation.
+     */
+    void indexBinary() {
+        bool chains = checkBinaryTreeHeader(serialized);
+        const char* begin = serialized.data();
+        const char* end = begin + serialized.size();
+        const char* cursor = begin + BINARY_TREE_HEADER_SIZE;
+
+        std::uint64_t recordCount = readVarint(cursor, end);
+        if (recordCount > static_cast<std::uint64_t>(end - cursor) / (chains ? 1 : 2)) {
+            throw std::invalid_argument("Invalid binary tree: node count exceeds data size");
+        }
+
+        std::string_view index = findBinaryIndex(serialized);
+        if (!index.empty() || recordCount == 0) {
+            if (index.size() / BINARY_INDEX_ENTRY_SIZE != recordCount) {
+                throw std::invalid_argument("Invalid binary tree: index entry count does not match node count");
+            }
+            persistedIndex = index;
+            offsetsAtHeaders = !chains;
+            nodeCount = static_cast<size_t>(recordCount);
+            return;
+        }
+        entries.reserve(recordCount);
+
+        // open node IDs paired with the children each still expects
+        std::vector<int> open;
+        std::vector<std::uint64_t> remaining;
+        RecordHeaderReader headers(chains);
+        for (std::uint64_t i = 0; i < recordCount; ++i) {
+            std::uint64_t expected = headers.next(cursor, end);
+            if (!remaining.empty()) {
+                --remaining.back();
+            }
+            openNode(static_cast<size_t>(cursor - begin), open);
+            remaining.push_back(expected);
+            T scratch;
+            Tree<T>::decodeBinaryValue(cursor, end, scratch);
+            while (!remaining.empty() && remaining.back() == 0) {
+                remaining.pop_back();
+                closeNode(open);
+            }
+        }
+        if (!open.empty()) {
+            throw std::invalid_argument("Invalid binary tree: fewer nodes than child counts require");
+        }
+    }
+
+    /**
+     * @brief Builds the index from a compressed container's structure block.
+     *
+     * Value blocks are left compressed; each node's offset is its payload's
+     * position within its own block, found by summing payload sizes.
+     *
+     * @throw std::invalid_argument If the layout is damaged or the child counts don't add up.
+     */
+    void indexCompressed() {
+        CompressedTreeLayout layout = readCompressedLayout(serialized);
+        blocks = std::move(layout.blocks);
+        const char* cursor = layout.structure.data();
+        const char* end = cursor + layout.structure.size();
+        entries.reserve(layout.nodeCount);
+
+        std::vector<int> open;
+        std::vector<std::uint64_t> remaining;
+        RecordHeaderReader headers(layout.chains);
+        size_t block = 0;
+        std::uint64_t offset = 0;
+        for (std::uint64_t i = 0; i < layout.nodeCount; ++i) {
+            if (block + 1 < blocks.size() && blocks[block + 1].firstNode == i) {
+                ++block;
+                offset = 0;
+            }
+            std::uint64_t expected = headers.next(cursor, end);
+            std::uint64_t payloadSize = readVarint(cursor, end);
+            if (offset + payloadSize > blocks[block].rawSize) {
+                throw std::invalid_argument("Invalid compressed tree: value runs past the end of its block");
+            }
+            if (!remaining.empty()) {
+                --remaining.back();
+            }
+            openNode(static_cast<size_t>(offset), open);
+            offset += payloadSize;
+            remaining.push_back(expected);
+            while (!remaining.empty() && remaining.back() == 0) {
+                remaining.pop_back();
+                closeNode(open);
+            }
+        }
+        if (!open.empty()) {
+            throw std::invalid_argument("Invalid compressed tree: fewer nodes than child counts require");
+        }
+    }
+
+    /**
+     * @brief Finds the value block holding a node of a compressed container.
+     */
+    size_t blockOf(int nodeID) const noexcept {
+        // the last block starting at or before the node
+        size_t low = 0, high = blocks.size();
+        while (high - low > 1) {
+            size_t middle = low + (high - low) / 2;
+            if (blocks[middle].firstNode <= static_cast<std::uint64_t>(nodeID)) {
+                low = middle;
+            } else {
+                high = middle;
+            }
+        }
+        return low;
+    }
+
+    /**
+     * @brief Decodes one node's value straight from the serialized data.
+     *
+     * @throw std::invalid_argument If the value cannot be parsed.
+     */
+    void decode(int nodeID, T& value) const {
+        if (compressed) {
+            size_t block = blockOf(nodeID);
+            if (block != loadedBlock) {
+                loadedBlock = static_cast<size_t>(-1);
+                readCompressedBlock(serialized, blocks[block], blockData);
+                loadedBlock = block;
+            }
+            const char* cursor = blockData.data() + entry(nodeID).offset;
+            Tree<T>::decodeBinaryValue(cursor, blockData.data() + blockData.size(), value);
+            return;
+        }
+        const char* begin = serialized.data();
+        const char* end = begin + serialized.size();
+        BinaryIndexEntry location = entry(nodeID);
+        if (location.offset >= serialized.size()) {
+            throw std::invalid_argument("Invalid tree index: node offset runs past end of data");
+        }
+        const char* cursor = begin + location.offset;
+        if (binary) {
+            if (offsetsAtHeaders) {
+                readVarint(cursor, end); // child count, already in the index
+            }
+            Tree<T>::decodeBinaryValue(cursor, end, value);
+            return;
+        }
+        std::string_view valuePart(cursor, static_cast<size_t>(findByte(cursor, end, '\n') - cursor));
+        if (!Tree<T>::parseValue(valuePart, value)) {
+            throw std::invalid_argument("Invalid tree serialization: unable to parse value: " + std::string(valuePart));
+        }
+    }
+};
+
+#endif // LAZYTREE_H
\ No newline at end of file
@@ -0,0 +1,246 @@
+/**
+ * Vectorized scanning for the serialized tree format.
+ *
+ * Loading a storyline is mostly a search for a handful of bytes: the '\n'
+ * ending every line, the "[X]" and "[X*n]" end-of-children tokens, the "]: " separating
+ * a node's ID from its value, and the '"' delimiters inside StoryNode values.
+ * These helpers compare 16 or 32 bytes at a time using AVX2, SSE2 or NEON,
+ * whichever the compiler targets, with a scalar fallback everywhere else.
+ * The instruction set is picked at compile time (e.g. build with -mavx2 to
+ * get the AVX2 path); SSE2 is always available on x86-64.
+ *
+ * LineScanner splits a whole buffer into line records in batches, so the
+ * parser can work through classified lines without any std::getline calls.
+ */
+
+#ifndef LINESCANNER_H
+#define LINESCANNER_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define LINESCANNER_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LINESCANNER_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define LINESCANNER_NEON 1
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+// Index of the lowest set bit; mask must be non-zero.
+inline unsigned lowestSetBit(std::uint64_t mask) noexcept {
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index;
+    _BitScanForward64(&index, mask);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctzll(mask));
+#endif
+}
+
+#if defined(LINESCANNER_AVX2)
+inline constexpr std::size_t SCAN_BLOCK_SIZE = 32;
+#elif defined(LINESCANNER_SSE2) || defined(LINESCANNER_NEON)
+inline constexpr std::size_t SCAN_BLOCK_SIZE = 16;
+#else
+inline constexpr std::size_t SCAN_BLOCK_SIZE = 8;
+#endif
+
+/**
+ * @brief Compares one block of SCAN_BLOCK_SIZE bytes against up to two needle bytes.
+ *
+ * @param block Start of the block; must have SCAN_BLOCK_SIZE readable bytes.
+ * @param first First byte to look for.
+ * @param second Second byte to look for; pass `first` again to look for one byte.
+ * @return std::uint64_t Bit i is set if block[i] matches either byte.
+ */
+inline std::uint64_t matchBlock(const char* block, char first, char second) noexcept {
+#if defined(LINESCANNER_AVX2)
+    __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+    __m256i matches = _mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(first)),
+                                      _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(second)));
+    return static_cast<std::uint32_t>(_mm256_movemask_epi8(matches));
+#elif defined(LINESCANNER_SSE2)
+    __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block));
+    __m128i matches = _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(first)),
+                                   _mm_cmpeq_epi8(bytes, _mm_set1_epi8(second)));
+    return static_cast<std::uint32_t>(_mm_movemask_epi8(matches));
+#elif defined(LINESCANNER_NEON)
+    uint8x16_t bytes = vld1q_u8(reinterpret_cast<const std::uint8_t*>(block));
+    uint8x16_t matches = vorrq_u8(vceqq_u8(bytes, vdupq_n_u8(static_cast<std::uint8_t>(first))),
+                                  vceqq_u8(bytes, vdupq_n_u8(static_cast<std::uint8_t>(second))));
+    // narrow each byte to 4 bits, then keep one bit per byte
+    std::uint64_t nibbles = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(matches), 4)), 0);
+    std::uint64_t mask = 0;
+    for (unsigned i = 0; i < 16; ++i) {
+        mask |= ((nibbles >> (i * 4)) & 1) << i;
+    }
+    return mask;
+#else
+    std::uint64_t mask = 0;
+    for (std::size_t i = 0; i < SCAN_BLOCK_SIZE; ++i) {
+        mask |= static_cast<std::uint64_t>(block[i] == first || block[i] == second) << i;
+    }
+    return mask;
+#endif
+}
+
+/**
+ * @brief Finds the first occurrence of either of two bytes.
+ *
+ * @param begin Start of the range.
+ * @param end One past the end of the range.
+ * @param first First byte to look for.
+ * @param second Second byte to look for.
+ * @return const char* The first match, or `end` if there is none.
+ */
+inline const char* findEither(const char* begin, const char* end, char first, char second) noexcept {
+    while (static_cast<std::size_t>(end - begin) >= SCAN_BLOCK_SIZE) {
+        std::uint64_t mask = matchBlock(begin, first, second);
+        if (mask) {
+            return begin + lowestSetBit(mask);
+        }
+        begin += SCAN_BLOCK_SIZE;
+    }
+    for (; begin != end; ++begin) {
+        if (*begin == first || *begin == second) {
+            return begin;
+        }
+    }
+    return end;
+}
+
+/**
+ * @brief Finds the first occurrence of a byte.
+ *
+ * @param begin Start of the range.
+ * @param end One past the end of the range.
+ * @param needle Byte to look for.
+ * @return const char* The first match, or `end` if there is none.
+ */
+inline const char* findByte(const char* begin, const char* end, char needle) noexcept {
+    return findEither(begin, end, needle, needle);
+}
+
+/**
+ * @brief One line of a serialized tree, classified by the scanner.
+ */
+struct LineRecord {
+    enum Kind : std::uint8_t {
+        NodeValue,     // "[n]: value"
+        EndOfChildren, // "[X]", or "[X*n]" for a run of n of them
+        Malformed      // anything else
+    };
+
+    std::string_view line; // Line contents, without the trailing '\n'
+    Kind kind;
+    std::size_t valueOffset; // Start of the value within `line`; only meaningful for NodeValue
+    std::size_t count = 1;   // End-of-children tokens the line stands for; only meaningful for EndOfChildren
+
+    std::string_view value() const noexcept { return line.substr(valueOffset); }
+};
+
+/**
+ * @brief Splits a serialized tree buffer into classified line records in batches.
+ *
+ * Newlines are located a whole block at a time, and every line is classified
+ * as a node, an end-of-children token, or malformed before any value is parsed.
+ * The scanner keeps views into the buffer, which must outlive the records.
+ */
+class LineScanner {
+public:
+    explicit LineScanner(std::string_view buffer) noexcept : buffer(buffer) {}
+
+    /**
+     * @brief Scans the next batch of lines.
+     *
+     * @param records Cleared, then filled with up to `maxRecords` records.
+     * @param maxRecords Upper bound on the batch size, which bounds the memory used.
+     * @return bool False once the whole buffer has been scanned and `records` is empty.
+     */
+    bool scan(std::vector<LineRecord>& records, std::size_t maxRecords = 4096) {
+        records.clear();
+        const char* data = buffer.data();
+        const char* end = data + buffer.size();
+        const char* lineStart = data + position;
+        const char* cursor = lineStart;
+
+        // whole blocks: every newline in a block is handled from one mask
+        while (records.size() < maxRecords && static_cast<std::size_t>(end - cursor) >= SCAN_BLOCK_SIZE) {
+            std::uint64_t mask = matchBlock(cursor, '\n', '\n');
+            while (mask && records.size() < maxRecords) {
+                const char* newline = cursor + lowestSetBit(mask);
+                mask &= mask - 1;
+                records.push_back(classify(std::string_view(lineStart, static_cast<std::size_t>(newline - lineStart))));
+                lineStart = newline + 1;
+            }
+            // a full batch may stop part way through a block; resume right after the last line
+            cursor = mask ? lineStart : cursor + SCAN_BLOCK_SIZE;
+        }
+        // tail shorter than a block
+        while (records.size() < maxRecords && lineStart != end) {
+            const char* newline = findByte(std::max(cursor, lineStart), end, '\n');
+            records.push_back(classify(std::string_view(lineStart, static_cast<std::size_t>(newline - lineStart))));
+            lineStart = newline == end ? end : newline + 1;
+            cursor = lineStart;
+        }
+
+        position = static_cast<std::size_t>(lineStart - data);
+        return !records.empty();
+    }
+
+    /**
+     * @brief Classifies a single line.
+     *
+     * @param line Line contents without the trailing '\n'.
+     * @return LineRecord The classified record.
+     */
+    static LineRecord classify(std::string_view line) noexcept {
+        if (line == "[X]") {
+            return LineRecord{line, LineRecord::EndOfChildren, 0};
+        }
+        // "[X*n]" closes n nodes at once; counts too long to be real are left malformed
+        if (line.size() > 4 && line.size() <= 4 + MAX_RUN_DIGITS && line.compare(0, 3, "[X*") == 0 && line.back() == ']') {
+            std::size_t count = 0;
+            for (char digit : line.substr(3, line.size() - 4)) {
+                if (digit < '0' || digit > '9') {
+                    return LineRecord{line, LineRecord::Malformed, 0};
+                }
+                count = count * 10 + static_cast<std::size_t>(digit - '0');
+            }
+            if (count > 0) {
+                return LineRecord{line, LineRecord::EndOfChildren, 0, count};
+            }
+        }
+        if (!line.empty() && line[0] == '[') {
+            const char* end = line.data() + line.size();
+            // the value starts after the first "]: "; IDs are short, so this is usually the first ']'
+            for (const char* bracket = findByte(line.data(), end, ']'); bracket != end;
+                 bracket = findByte(bracket + 1, end, ']')) {
+                if (end - bracket >= 3 && bracket[1] == ':' && bracket[2] == ' ') {
+                    return LineRecord{line, LineRecord::NodeValue, static_cast<std::size_t>(bracket - line.data()) + 3};
+                }
+            }
+        }
+        return LineRecord{line, LineRecord::Malformed, 0};
+    }
+
+private:
+    static constexpr std::size_t MAX_RUN_DIGITS = 18; // Keeps run counts well inside size_t
+
+    std::string_view buffer;
+    std::size_t position = 0; // Start of the first line not yet scanned
+};
+
+#endif // LINESCANNER_H
@@ -0,0 +1,75 @@
+#include <stdexcept>
+#include <string>
+
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <fstream>
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string& filePath) {
+    std::ifstream inFile(filePath, std::ios::binary);
+    if (!inFile) {
+        throw std::runtime_error("Unable to open file: " + filePath);
+    }
+    buffer.assign(std::istreambuf_iterator<char>(inFile), std::istreambuf_iterator<char>());
+    begin = buffer.data();
+    length = buffer.size();
+}
+
+MappedFile::~MappedFile() = default;
+
+// the whole file was read by the constructor
+void MappedFile::prefetch() const noexcept {}
+
+#else
+
+MappedFile::MappedFile(const std::string& filePath) {
+    int fd = ::open(filePath.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Unable to open file: " + filePath);
+    }
+
+    struct stat fileInfo;
+    if (::fstat(fd, &fileInfo) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Unable to stat file: " + filePath);
+    }
+    length = static_cast<std::size_t>(fileInfo.st_size);
+
+    // mmap rejects zero-length mappings; an empty file is simply an empty view
+    if (length > 0) {
+        void* mapping = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("Unable to map file: " + filePath);
+        }
+        // storylines are parsed front to back
+        ::madvise(mapping, length, MADV_SEQUENTIAL);
+        begin = static_cast<const char*>(mapping);
+    }
+    // the mapping stays valid after the descriptor is closed
+    ::close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (begin) {
+        ::munmap(const_cast<char*>(begin), length);
+    }
+}
+
+void MappedFile::prefetch() const noexcept {
+    if (begin) {
+        ::madvise(const_cast<char*>(begin), length, MADV_WILLNEED);
+    }
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,48 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Read-only view of a whole file's contents.
+ * 
+ * Maps the file into memory with mmap on POSIX systems, so loading a large
+ * storyline costs a page-cache mapping instead of heap copies. On platforms
+ * without mmap the file is read into a single buffer instead. The contents
+ * stay valid for the lifetime of the object.
+ */
+class MappedFile {
+public:
+    /**
+     * @brief Maps a file for reading.
+     * 
+     * @param filePath file to map
+     * @throw std::runtime_error If the file cannot be opened or mapped.
+     */
+    explicit MappedFile(const std::string& filePath);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    std::string_view data() const noexcept { return std::string_view(begin, length); }
+
+    /**
+     * @brief Asks the OS to start reading the whole file in the background.
+     * 
+     * Returns immediately; a parser working through data() front to back then
+     * overlaps with the disk reads instead of faulting in each page on demand.
+     */
+    void prefetch() const noexcept;
+
+private:
+    const char* begin = nullptr;
+    std::size_t length = 0;
+#ifdef _WIN32
+    std::string buffer; // fallback storage when mmap is unavailable
+#endif
+};
+
+#endif // MAPPEDFILE_H
\ No newline at end of file
@@ -0,0 +1,210 @@
+/**
+ * Fixed-size block allocator behind Node's class-specific operator new.
+ *
+ * Trees allocate one Node per story beat and free them all together when a
+ * storyline is replaced, so nearly every allocation is the same size and the
+ * general-purpose heap is mostly paying for bookkeeping it doesn't need.
+ * NodePool carves blocks of one size out of large slabs and recycles freed
+ * blocks through free lists, without returning memory to the system.
+ *
+ *
+ * FREE LISTS
+ * __________
+ *
+ *  thread A cache:  [b]->[b]->[b]             <--- no locking, up to 2 * NODE_POOL_BATCH blocks
+ *  thread B cache:  [b]->[b]
+ *  shared list:     [b]->[b]->[b]->[b]->...   <--- mutex, refilled from new slabs when empty
+ *
+ *
+ * Each thread allocates from and frees into its own cache. A cache that runs
+ * dry takes NODE_POOL_BATCH blocks from the shared list, and one that grows
+ * past twice that hands a batch back, so trees built on one thread and
+ * destroyed on another (a hot reload, a pool task) keep their memory in
+ * circulation. A thread's cache is returned to the shared list when the
+ * thread exits; frees after that go straight to the shared list.
+ *
+ * Blocks are keyed by size and alignment, not by type, so nodes of different
+ * value types that happen to have the same layout share a pool. Define
+ * TREE_NO_NODE_POOL to allocate nodes with the global operator new instead,
+ * e.g. for sanitizer builds that should see every node's lifetime.
+ */
+
+#ifndef NODEPOOL_H
+#define NODEPOOL_H
+
+#include <algorithm>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#if defined(TREE_NO_NODE_POOL)
+inline constexpr bool NODE_POOL_ENABLED = false;
+#else
+inline constexpr bool NODE_POOL_ENABLED = true;
+#endif
+
+// Blocks moved between a thread's cache and the shared list at a time
+inline constexpr std::size_t NODE_POOL_BATCH = 64;
+// Bytes requested from the global allocator per slab
+inline constexpr std::size_t NODE_POOL_SLAB_SIZE = 64 * 1024;
+
+/**
+ * @brief Thread-safe pool of fixed-size blocks.
+ *
+ * @tparam Size Size of each block.
+ * @tparam Align Alignment of each block.
+ */
+template <std::size_t Size, std::size_t Align>
+class NodePool {
+public:
+    /**
+     * @brief Takes a block from the calling thread's cache, refilling it if empty.
+     *
+     * @return void* Uninitialized storage for `Size` bytes.
+     * @throw std::bad_alloc If a new slab cannot be allocated.
+     */
+    static void* allocate() {
+        Cache& local = cache();
+        if (!local.head) {
+            if (local.closed) {
+                return takeShared();
+            }
+            refill(local);
+        }
+        FreeBlock* block = local.head;
+        local.head = block->next;
+        --local.count;
+        return block;
+    }
+
+    /**
+     * @brief Returns a block to the calling thread's cache.
+     *
+     * @param pointer Block obtained from `allocate`, on any thread.
+     */
+    static void deallocate(void* pointer) noexcept {
+        Cache& local = cache();
+        FreeBlock* block = static_cast<FreeBlock*>(pointer);
+        if (local.closed) {
+            Shared& pool = shared();
+            std::lock_guard<std::mutex> lock(pool.mutex);
+            block->next = pool.head;
+            pool.head = block;
+            return;
+        }
+        if (local.count == 0) {
+            watchThreadExit();
+        }
+        block->next = local.head;
+        local.head = block;
+        if (++local.count > 2 * NODE_POOL_BATCH) {
+            giveBack(local, NODE_POOL_BATCH);
+        }
+    }
+
+private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    static constexpr std::size_t blockAlign = std::max(Align, alignof(FreeBlock));
+    // rounded up so consecutive blocks in a slab stay aligned
+    static constexpr std::size_t blockSize =
+        (std::max(Size, sizeof(FreeBlock)) + blockAlign - 1) / blockAlign * blockAlign;
+    static constexpr std::size_t slabBlocks = std::max<std::size_t>(NODE_POOL_BATCH, NODE_POOL_SLAB_SIZE / blockSize);
+
+    // Trivially destructible, so it stays usable by frees that run after the thread's destructors
+    struct Cache {
+        FreeBlock* head;
+        std::size_t count;
+        bool closed;
+    };
+
+    // Hands the thread's cache back when the thread exits
+    struct CacheCloser {
+        ~CacheCloser() {
+            Cache& local = cache();
+            giveBack(local, local.count);
+            local.closed = true;
+        }
+    };
+
+    struct Shared {
+        std::mutex mutex;
+        FreeBlock* head = nullptr;
+        std::vector<void*> slabs; // Never freed; blocks may be in use until the process exits
+    };
+
+    static Cache& cache() noexcept {
+        static thread_local Cache local{nullptr, 0, false};
+        return local;
+    }
+
+    static Shared& shared() noexcept {
+        // leaked on purpose, so nodes of static trees can still be freed during shutdown
+        static Shared* pool = new Shared();
+        return *pool;
+    }
+
+    // Carves a new slab and links all of its blocks; the caller holds the shared lock.
+    static FreeBlock* newSlab(Shared& pool) {
+        unsigned char* slab = static_cast<unsigned char*>(
+            ::operator new(slabBlocks * blockSize, std::align_val_t(blockAlign)));
+        pool.slabs.push_back(slab);
+        FreeBlock* head = nullptr;
+        for (std::size_t i = slabBlocks; i-- > 0;) {
+            FreeBlock* block = reinterpret_cast<FreeBlock*>(slab + i * blockSize);
+            block->next = head;
+            head = block;
+        }
+        return head;
+    }
+
+    // Constructs the thread's closer on first use, so a cache that ever holds blocks is handed back
+    static void watchThreadExit() noexcept {
+        static thread_local CacheCloser closer;
+        (void)closer;
+    }
+
+    static void refill(Cache& local) {
+        watchThreadExit();
+        Shared& pool = shared();
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        if (!pool.head) {
+            pool.head = newSlab(pool);
+        }
+        for (std::size_t i = 0; i < NODE_POOL_BATCH && pool.head; ++i) {
+            FreeBlock* block = pool.head;
+            pool.head = block->next;
+            block->next = local.head;
+            local.head = block;
+            ++local.count;
+        }
+    }
+
+    static void giveBack(Cache& local, std::size_t count) noexcept {
+        Shared& pool = shared();
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        for (std::size_t i = 0; i < count && local.head; ++i) {
+            FreeBlock* block = local.head;
+            local.head = block->next;
+            --local.count;
+            block->next = pool.head;
+            pool.head = block;
+        }
+    }
+
+    static void* takeShared() {
+        Shared& pool = shared();
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        if (!pool.head) {
+            pool.head = newSlab(pool);
+        }
+        FreeBlock* block = pool.head;
+        pool.head = block->next;
+        return block;
+    }
+};
+
+#endif // NODEPOOL_H
\ No newline at end of file
@@ -0,0 +1,213 @@
+/**
+ * Whole-tree walks spread over a ThreadPool.
+ *
+ * The tree is cut at a split depth: every node above it is visited on the
+ * calling thread while the frontier is found, and each node at the split
+ * depth roots an independent subtree that becomes one pool task. Subtrees
+ * don't share nodes, so tasks never contend for anything but the pool.
+ *
+ *
+ * SPLITTING AT DEPTH 2
+ * ____________________
+ *
+ *           1              depth 0   visited by the caller
+ *         /   \
+ *        2     3           depth 1   visited by the caller
+ *       / \    |
+ *     [4] [5] [6]          depth 2   one task each, walking its whole subtree
+ *     /|   |
+ *    7 8   9
+ *
+ *
+ * Without an explicit depth the frontier is deepened one level at a time
+ * until there are several subtrees per worker, so stealing can even out
+ * subtrees of very different sizes.
+ */
+
+#ifndef PARALLELTREE_H
+#define PARALLELTREE_H
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "ThreadPool.h"
+#include "Tree.h"
+
+// Subtrees per worker aimed for when the split depth is picked automatically
+inline constexpr size_t PARALLEL_SUBTREES_PER_WORKER = 4;
+// Deepest level an automatic split will go to; chains never widen, and every level above runs serially
+inline constexpr size_t PARALLEL_MAX_AUTO_SPLIT_DEPTH = 32;
+
+/**
+ * @brief Calls a node callback with whichever arguments it accepts, like Tree::visit does.
+ * 
+ * @return bool False if the callback asked to skip the node's descendants.
+ */
+template <typename F, typename Ref>
+bool invokeNodeCallback(F& callback, const Ref& node, size_t depth) {
+    if constexpr (std::is_invocable_v<F&, const Ref&, size_t>) {
+        if constexpr (std::is_same_v<std::invoke_result_t<F&, const Ref&, size_t>, bool>) {
+            return callback(node, depth);
+        } else {
+            callback(node, depth);
+            return true;
+        }
+    } else {
+        if constexpr (std::is_same_v<std::invoke_result_t<F&, const Ref&>, bool>) {
+            return callback(node);
+        } else {
+            callback(node);
+            return true;
+        }
+    }
+}
+
+/**
+ * @brief Visits the nodes above the split on the calling thread and collects the subtree roots below it.
+ * 
+ * @param tree Tree to split.
+ * @param splitDepth Depth of the subtree roots, or 0 to pick one from `targetCount`.
+ * @param targetCount Number of subtrees an automatic split stops at.
+ * @param onTop Called for every node above the split; returning false prunes it.
+ * @return std::vector<std::pair<int, size_t>> Each subtree root with its depth.
+ */
+template <typename T, typename F>
+std::vector<std::pair<int, size_t>> splitSubtrees(const Tree<T>& tree, size_t splitDepth, size_t targetCount, F&& onTop) {
+    std::vector<std::pair<int, size_t>> frontier;
+    if (tree.getRootID() == -1) {
+        return frontier;
+    }
+    frontier.push_back({tree.getRootID(), 0});
+
+    std::vector<std::pair<int, size_t>> next;
+    for (size_t depth = 0; !frontier.empty(); ++depth) {
+        bool deepEnough = splitDepth ? depth == splitDepth
+                                     : frontier.size() >= targetCount || depth == PARALLEL_MAX_AUTO_SPLIT_DEPTH;
+        if (deepEnough) {
+            break;
+        }
+        next.clear();
+        for (auto [nodeID, nodeDepth] : frontier) {
+            if (!onTop(typename Tree<T>::NodeRef{nodeID, tree[nodeID]}, nodeDepth)) {
+                continue;
+            }
+            for (auto child : tree.children(nodeID)) {
+                next.push_back({child.id, nodeDepth + 1});
+            }
+        }
+        frontier.swap(next);
+    }
+    return frontier;
+}
+
+/**
+ * @brief Calls a visitor on every node of the tree, spreading subtrees over a thread pool.
+ * 
+ * The visitor is called as `visitor(NodeRef)` or `visitor(NodeRef, size_t depth)`,
+ * with depth measured from the tree's root, and may return false to prune a
+ * node's descendants, exactly as with Tree::visit. Nodes within one subtree
+ * are visited in pre-order, but different subtrees run concurrently, so the
+ * visitor must be safe to call from several threads at once.
+ * The tree must not be modified until the call returns.
+ * 
+ * @param tree Tree to walk.
+ * @param pool Pool that runs the subtrees.
+ * @param splitDepth Depth at which the tree is cut into subtrees; 0 picks one from the pool's size.
+ * @param visitor Callable invoked once per visited node.
+ * @throw Rethrows the first exception thrown by the visitor.
+ */
+template <typename T, typename F>
+void parallelForEachSubtree(const Tree<T>& tree, ThreadPool& pool, size_t splitDepth, F&& visitor) {
+    using Ref = typename Tree<T>::NodeRef;
+    auto roots = splitSubtrees(tree, splitDepth, PARALLEL_SUBTREES_PER_WORKER * pool.size(),
+                               [&](const Ref& node, size_t depth) { return invokeNodeCallback(visitor, node, depth); });
+    // a group rather than the whole pool, so unrelated tasks don't hold this up and calls can nest inside tasks
+    ThreadPool::TaskGroup group(pool);
+    for (auto [rootID, rootDepth] : roots) {
+        group.submit([&tree, &visitor, rootID = rootID, rootDepth = rootDepth]() {
+            tree.visit(rootID, [&](const Ref& node, size_t depth) {
+                return invokeNodeCallback(visitor, node, rootDepth + depth);
+            });
+        });
+    }
+    group.wait();
+}
+
+/**
+ * @brief Calls a visitor on every node of the tree, picking the split depth automatically.
+ * 
+ * @see parallelForEachSubtree(const Tree<T>&, ThreadPool&, size_t, F&&)
+ */
+template <typename T, typename F>
+void parallelForEachSubtree(const Tree<T>& tree, ThreadPool& pool, F&& visitor) {
+    parallelForEachSubtree(tree, pool, 0, std::forward<F>(visitor));
+}
+
+/**
+ * @brief Maps every node to a value and folds the values together, one subtree per task.
+ * 
+ * Each subtree is folded into its own partial result starting from `identity`,
+ * and the partial results are combined on the calling thread once every subtree
+ * is done. Nodes are not combined in pre-order, so `combine` must be associative
+ * and commutative. `map` is called as `map(NodeRef)` or `map(NodeRef, size_t depth)`
+ * and must be safe to call from several threads at once.
+ * 
+ * @param tree Tree to walk.
+ * @param pool Pool that runs the subtrees.
+ * @param splitDepth Depth at which the tree is cut into subtrees; 0 picks one from the pool's size.
+ * @param identity Starting value, returned for an empty tree.
+ * @param map Turns a node into a value.
+ * @param combine Merges two values.
+ * @return R The combined value over every node.
+ * @throw Rethrows the first exception thrown by `map` or `combine`.
+ */
+template <typename T, typename R, typename Map, typename Combine>
+R parallelReduce(const Tree<T>& tree, ThreadPool& pool, size_t splitDepth, R identity, Map&& map, Combine&& combine) {
+    using Ref = typename Tree<T>::NodeRef;
+    auto mapNode = [&map](const Ref& node, size_t depth) {
+        if constexpr (std::is_invocable_v<Map&, const Ref&, size_t>) {
+            return map(node, depth);
+        } else {
+            return map(node);
+        }
+    };
+
+    R result = identity;
+    auto roots = splitSubtrees(tree, splitDepth, PARALLEL_SUBTREES_PER_WORKER * pool.size(), [&](const Ref& node, size_t depth) {
+        result = combine(std::move(result), mapNode(node, depth));
+        return true;
+    });
+
+    std::vector<R> partials(roots.size(), identity);
+    ThreadPool::TaskGroup group(pool);
+    for (size_t i = 0; i < roots.size(); ++i) {
+        group.submit([&, i]() {
+            auto [rootID, rootDepth] = roots[i];
+            R partial = identity;
+            tree.visit(rootID, [&](const Ref& node, size_t depth) {
+                partial = combine(std::move(partial), mapNode(node, rootDepth + depth));
+            });
+            partials[i] = std::move(partial);
+        });
+    }
+    group.wait();
+
+    for (R& partial : partials) {
+        result = combine(std::move(result), std::move(partial));
+    }
+    return result;
+}
+
+/**
+ * @brief Maps and folds every node, picking the split depth automatically.
+ * 
+ * @see parallelReduce(const Tree<T>&, ThreadPool&, size_t, R, Map&&, Combine&&)
+ */
+template <typename T, typename R, typename Map, typename Combine>
+R parallelReduce(const Tree<T>& tree, ThreadPool& pool, R identity, Map&& map, Combine&& combine) {
+    return parallelReduce(tree, pool, 0, std::move(identity), std::forward<Map>(map), std::forward<Combine>(combine));
+}
+
+#endif // PARALLELTREE_H
\ No newline at end of file
@@ -0,0 +1,157 @@
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include "SessionEngine.h"
+#include "TreeMetrics.h"
+
+SessionEngine::SessionEngine(std::shared_ptr<const FrozenTree<StoryNode>> story, unsigned workerCount, TurnHandler onTurn)
+    : published(std::make_shared<const StoryVersion>(StoryVersion{std::move(story), {}, {}})), onTurn(std::move(onTurn)) {
+    if (workerCount == 0) {
+        workerCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    workers.reserve(workerCount);
+    for (unsigned i = 0; i < workerCount; ++i) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+    // start the threads only once every worker exists
+    for (auto& worker : workers) {
+        worker->thread = std::thread(&SessionEngine::run, this, std::ref(*worker));
+    }
+}
+
+SessionEngine::~SessionEngine() {
+    for (auto& worker : workers) {
+        std::lock_guard<std::mutex> lock(worker->mutex);
+        worker->stopping = true;
+        worker->ready.notify_one();
+    }
+    for (auto& worker : workers) {
+        worker->thread.join();
+    }
+}
+
+SessionEngine::SessionID SessionEngine::openSession() {
+    SessionID session = nextSession.fetch_add(1, std::memory_order_relaxed);
+    enqueue(Event{Event::Kind::Open, session, 0});
+    return session;
+}
+
+void SessionEngine::submitChoice(SessionID session, int choice) {
+    enqueue(Event{Event::Kind::Choice, session, choice});
+}
+
+void SessionEngine::closeSession(SessionID session) {
+    enqueue(Event{Event::Kind::Close, session, 0});
+}
+
+void SessionEngine::publish(std::shared_ptr<const FrozenTree<StoryNode>> story) {
+    std::lock_guard<std::mutex> lock(publishMutex);
+    std::shared_ptr<const StoryVersion> current = std::atomic_load(&published);
+    std::vector<int> fromPrevious = mapUnchangedNodes(*current->tree, *story);
+    auto next = std::make_shared<const StoryVersion>(StoryVersion{std::move(story), current, std::move(fromPrevious)});
+    std::atomic_store(&published, std::shared_ptr<const StoryVersion>(std::move(next)));
+    publishCount.fetch_add(1, std::memory_order_release);
+}
+
+void SessionEngine::enqueue(const Event& event) {
+    Worker& worker = *workers[event.session % workers.size()];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    worker.queue.push_back(event);
+    worker.ready.notify_one();
+}
+
+void SessionEngine::run(Worker& worker) {
+    std::deque<Event> batch;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(worker.mutex);
+            worker.ready.wait(lock, [&] { return worker.stopping || !worker.queue.empty(); });
+            if (worker.queue.empty()) {
+                return; // stopping, and everything queued has been handled
+            }
+            // take the whole queue at once so producers are blocked as briefly as possible
+            batch.swap(worker.queue);
+        }
+        for (const Event& event : batch) {
+            TurnResult result = handle(worker, event);
+            if (onTurn) {
+                onTurn(result);
+            }
+            worker.turnStory.reset();
+        }
+        batch.clear();
+    }
+}
+
+SessionEngine::TurnResult SessionEngine::handle(Worker& worker, const Event& event) {
+    // one counter load per input; the shared handle itself is only reloaded after a publish
+    std::uint64_t number = publishCount.load(std::memory_order_acquire);
+    if (!worker.latest || number != worker.latestNumber) {
+        worker.latest = std::atomic_load(&published);
+        worker.latestNumber = number;
+    }
+
+    if (event.kind == Event::Kind::Open) {
+        const FrozenTree<StoryNode>& tree = *worker.latest->tree;
+        int rootID = tree.getRootID();
+        worker.sessions.emplace(event.session, Session{worker.latest, rootID, {}});
+        bool ended = rootID == -1 || tree.childCount(rootID) == 0;
+        return TurnResult{event.session, ended ? TurnStatus::Ended : TurnStatus::Started, rootID, &tree};
+    }
+
+    auto sessionItr = worker.sessions.find(event.session);
+    if (sessionItr == worker.sessions.end()) {
+        return TurnResult{event.session, TurnStatus::UnknownSession, -1, nullptr};
+    }
+    Session& session = sessionItr->second;
+    upgrade(session, worker.latest);
+    const FrozenTree<StoryNode>& tree = *session.story->tree;
+
+    if (event.kind == Event::Kind::Close) {
+        int nodeID = session.currentNodeID;
+        worker.turnStory = std::move(session.story);
+        worker.sessions.erase(sessionItr);
+        return TurnResult{event.session, TurnStatus::Closed, nodeID, &tree};
+    }
+
+    // Handle a choice
+    TREE_METRICS_TIME(turnLatency);
+    if (session.currentNodeID == -1) {
+        return TurnResult{event.session, TurnStatus::Ended, -1, &tree};
+    }
+    auto children = tree.children(session.currentNodeID);
+    if (event.choice < 1 || event.choice > static_cast<int>(children.size())) {
+        TurnStatus status = children.empty() ? TurnStatus::Ended : TurnStatus::InvalidChoice;
+        return TurnResult{event.session, status, session.currentNodeID, &tree};
+    }
+
+    session.history.push_back(session.currentNodeID);
+    session.currentNodeID = (*std::next(children.begin(), event.choice - 1)).id;
+    bool ended = tree.childCount(session.currentNodeID) == 0;
+    return TurnResult{event.session, ended ? TurnStatus::Ended : TurnStatus::Advanced, session.currentNodeID, &tree};
+}
+
+// Moves a session to the latest version if it is one version behind and its path is unchanged there.
+void SessionEngine::upgrade(Session& session, const std::shared_ptr<const StoryVersion>& latest) const {
+    if (session.story == latest || session.currentNodeID == -1) {
+        return;
+    }
+    std::shared_ptr<const StoryVersion> previous = latest->previous.lock();
+    if (previous != session.story) {
+        return; // more than one version behind; no mapping to follow
+    }
+    const std::vector<int>& mapping = latest->fromPrevious;
+    if (mapping[session.currentNodeID] == -1) {
+        return;
+    }
+    // a node only maps if its ancestors do, so the whole history carries over
+    session.currentNodeID = mapping[session.currentNodeID];
+    for (int& nodeID : session.history) {
+        nodeID = mapping[nodeID];
+    }
+    session.story = latest;
+}
\ No newline at end of file
@@ -0,0 +1,162 @@
+#ifndef SESSIONENGINE_H
+#define SESSIONENGINE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "StoryNode.h"
+#include "FrozenTree.h"
+
+/**
+ * @brief Runs many concurrent player sessions against one shared storyline.
+ * 
+ * The story tree is loaded once and shared read-only by every session; a
+ * session only stores the node it is on and the nodes it has visited, so
+ * memory grows with the number of sessions rather than sessions times tree
+ * size. The story is a FrozenTree, which can never be modified, so the read
+ * path takes no locks and walks compact pre-order arrays.
+ * 
+ * Inputs from connections are queued with openSession/submitChoice/closeSession
+ * and handled by a fixed pool of worker threads. Each session is pinned to one
+ * worker (by session ID), so its state is only ever touched by that thread and
+ * needs no locking either; the only synchronization is the per-worker queue.
+ * Results are delivered through the handler passed to the constructor, which
+ * is called on the worker threads.
+ * 
+ * A new version of the story can be published at any time without stopping
+ * the workers (see StoryWatcher). New sessions start on the latest version.
+ * A running session moves to it at its next input when its whole path so far
+ * is unchanged in the new version; otherwise it finishes on the version it
+ * started on, which stays alive until its last session closes.
+ */
+class SessionEngine {
+public:
+    using SessionID = std::uint64_t;
+
+    // What happened to a session as the result of one input.
+    enum class TurnStatus {
+        Started,        // session opened on the root node
+        Advanced,       // choice accepted, session moved to a child node
+        InvalidChoice,  // choice out of range, session unchanged
+        Ended,          // session reached a node with no children
+        Closed,         // session closed by the caller
+        UnknownSession  // input for a session that does not exist
+    };
+
+    struct TurnResult {
+        SessionID session;
+        TurnStatus status;
+        int nodeID; // node the session is on after the input, -1 if none
+        const FrozenTree<StoryNode>* story; // version nodeID belongs to; valid until the handler returns
+    };
+
+    using TurnHandler = std::function<void(const TurnResult&)>;
+
+    /**
+     * @brief Starts the worker threads.
+     * 
+     * @param story immutable tree shared by every session
+     * @param workerCount number of worker threads; 0 uses the hardware concurrency
+     * @param onTurn called on a worker thread after every handled input
+     */
+    SessionEngine(std::shared_ptr<const FrozenTree<StoryNode>> story, unsigned workerCount, TurnHandler onTurn);
+
+    // Stops the workers after they finish the inputs already queued.
+    ~SessionEngine();
+
+    SessionEngine(const SessionEngine&) = delete;
+    SessionEngine& operator=(const SessionEngine&) = delete;
+
+    /**
+     * @brief Opens a new session positioned at the root of the story.
+     * 
+     * @return SessionID ID to use for the session's later inputs
+     */
+    SessionID openSession();
+
+    /**
+     * @brief Queues a player's choice for a session.
+     * 
+     * @param session session to advance
+     * @param choice 1-based index of the chosen child, as shown to the player
+     */
+    void submitChoice(SessionID session, int choice);
+
+    /**
+     * @brief Queues the end of a session, releasing its state.
+     * 
+     * @param session session to close
+     */
+    void closeSession(SessionID session);
+
+    /**
+     * @brief Makes a new version of the story the one new sessions start on.
+     * 
+     * Safe to call from any thread while sessions are running. The IDs of
+     * unchanged nodes are mapped from the current version here, on the calling
+     * thread, so the workers never stall on it.
+     * 
+     * @param story the new version
+     */
+    void publish(std::shared_ptr<const FrozenTree<StoryNode>> story);
+
+    /**
+     * @brief Gets the version of the story new sessions start on.
+     */
+    std::shared_ptr<const FrozenTree<StoryNode>> story() const { return std::atomic_load(&published)->tree; }
+
+private:
+    // One published version of the story, with the way nodes of the version before it map into it.
+    struct StoryVersion {
+        std::shared_ptr<const FrozenTree<StoryNode>> tree;
+        std::weak_ptr<const StoryVersion> previous;
+        std::vector<int> fromPrevious; // IDs in `previous` mapped to IDs in `tree`, -1 where changed
+    };
+
+    struct Session {
+        std::shared_ptr<const StoryVersion> story; // version the session is playing
+        int currentNodeID;
+        std::vector<int> history; // nodes visited before the current one
+    };
+
+    struct Event {
+        enum class Kind { Open, Choice, Close } kind;
+        SessionID session;
+        int choice;
+    };
+
+    // One worker thread with its input queue and the sessions pinned to it.
+    struct Worker {
+        std::mutex mutex;
+        std::condition_variable ready;
+        std::deque<Event> queue;
+        bool stopping = false;
+        std::unordered_map<SessionID, Session> sessions; // only touched by the worker thread
+        std::shared_ptr<const StoryVersion> latest;       // worker's copy of `published`
+        std::uint64_t latestNumber = 0;                   // publishCount when `latest` was read
+        std::shared_ptr<const StoryVersion> turnStory;    // keeps a closed session's version alive for the handler
+        std::thread thread;
+    };
+
+    void enqueue(const Event& event);
+    void run(Worker& worker);
+    TurnResult handle(Worker& worker, const Event& event);
+    void upgrade(Session& session, const std::shared_ptr<const StoryVersion>& latest) const;
+
+    std::shared_ptr<const StoryVersion> published; // only accessed through std::atomic_load/atomic_store
+    std::atomic<std::uint64_t> publishCount{0};    // bumped after every store, so workers reload only on change
+    std::mutex publishMutex;                       // orders concurrent publish calls
+    TurnHandler onTurn;
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::atomic<SessionID> nextSession{0};
+};
+
+#endif // SESSIONENGINE_H
\ No newline at end of file
@@ -1,28 +1,173 @@
 #include <cctype>
 #include <iostream>
 #include <string>
+#include <string_view>
 
+#include "BinaryCodec.h"
+#include "LineScanner.h"
 #include "StoryNode.h"
 
+// Writes text with '"' and '\\' escaped by a backslash, so quotes inside a field survive a round trip.
+static void writeEscaped(std::ostream &os, std::string_view text) {
+    const char *position = text.data();
+    const char *end = position + text.size();
+    const char *special = findEither(position, end, '"', '\\');
+    while(special != end){
+        os.write(position, special - position);
+        os.put('\\');
+        os.put(*special);
+        position = special + 1;
+        special = findEither(position, end, '"', '\\');
+    }
+    os.write(position, end - position);
+}
+
+// Reads a quoted field starting just after its opening quote, undoing writeEscaped.
+// Returns the position just past the closing quote, or npos if the field is unterminated.
+static size_t readQuoted(std::string_view text, size_t start, std::string &out) {
+    out.clear();
+    size_t position = start;
+    const char *end = text.data() + text.size();
+    while(true){
+        const char *found = findEither(text.data() + position, end, '"', '\\');
+        if(found == end){
+            return std::string_view::npos;
+        }
+        size_t special = static_cast<size_t>(found - text.data());
+        out.append(text.data() + position, special - position);
+        if(text[special] == '"'){
+            return special + 1;
+        }
+        if(special + 1 == text.size()){ // dangling backslash
+            return std::string_view::npos;
+        }
+        out.push_back(text[special + 1]);
+        position = special + 2;
+    }
+}
+
 std::ostream& operator <<(std::ostream &os, const StoryNode &sn) { // conversion from "StoryNode" type to "string".
-    os << "action: \"" << sn.action << "\" outcome: \"" << sn.outcome << "\"";
+    os << "action: \"";
+    writeEscaped(os, sn.action);
+    os << "\" outcome: \"";
+    writeEscaped(os, sn.outcome);
+    os << "\"";
     return os;
 }
 
 std::istream& operator >>(std::istream &is, StoryNode &sn) { // conversion from "string" to "StoryNode"
     std::string buffer;
     std::getline(is, buffer);
-    if(!buffer.empty() && buffer.back() == ' '){ // supposed to minimize whitespace.
-        buffer.pop_back();
+    if(!parse(buffer, sn)){
+        is.setstate(std::ios::failbit);
+    }
+    return is;
+}
+
+bool parse(std::string_view text, StoryNode &sn) {
+    if(!text.empty() && text.back() == ' '){ // supposed to minimize whitespace.
+        text.remove_suffix(1);
+    }
+
+    // scans straight over the text; fields are assigned in place, reusing their capacity
+    size_t actionPos = text.find("action: \"");
+    if(actionPos == std::string_view::npos){
+        return false;
     }
+    size_t actionEnd = readQuoted(text, actionPos + 9, sn.action);
+    if(actionEnd == std::string_view::npos){
+        return false;
+    }
+
+    size_t outcomePos = text.find("outcome: \"", actionEnd);
+    if(outcomePos == std::string_view::npos){
+        return false;
+    }
+    return readQuoted(text, outcomePos + 10, sn.outcome) != std::string_view::npos;
+}
+
+void encodeBinary(std::string &out, const StoryNode &sn) {
+    writeLengthPrefixed(out, sn.action);
+    writeLengthPrefixed(out, sn.outcome);
+}
+
+void decodeBinary(const char *&cursor, const char *end, StoryNode &sn) {
+    sn.action = std::string(readLengthPrefixed(cursor, end));
+    sn.outcome = std::string(readLengthPrefixed(cursor, end));
+}
+
+std::ostream& operator <<(std::ostream &os, const StoryNodeView &sn) {
+    os << "action: \"";
+    writeEscaped(os, sn.action);
+    os << "\" outcome: \"";
+    writeEscaped(os, sn.outcome);
+    os << "\"";
+    return os;
+}
 
-    //Initializing "action" and "outcome" struct members with substrings from buffer (special thanks to Alec for helping me with this).
-    size_t actionPos = buffer.find("action: \"");
-    size_t actionEnd = buffer.find("\"", actionPos + 9);
-    sn.action = buffer.substr(actionPos + 9, actionEnd - (actionPos + 9));
+std::istream& operator >>(std::istream &is, StoryNodeView &) {
+    is.setstate(std::ios::failbit);
+    return is;
+}
+
+// Finds the closing quote of a field that has no escape sequences; npos if unterminated or escaped.
+static size_t findPlainQuote(std::string_view text, size_t start) {
+    const char *end = text.data() + text.size();
+    const char *special = findEither(text.data() + start, end, '"', '\\');
+    if(special == end || *special != '"'){
+        return std::string_view::npos;
+    }
+    return static_cast<size_t>(special - text.data());
+}
+
+bool parseView(std::string_view text, StoryNodeView &sn) {
+    while(!text.empty() && (text.back() == ' ' || text.back() == '\r')){
+        text.remove_suffix(1);
+    }
+
+    size_t actionPos = text.find("action: \"");
+    if(actionPos == std::string_view::npos){
+        return false;
+    }
+    size_t actionEnd = findPlainQuote(text, actionPos + 9);
+    if(actionEnd == std::string_view::npos){
+        return false;
+    }
+
+    size_t outcomePos = text.find("outcome: \"", actionEnd);
+    if(outcomePos == std::string_view::npos){
+        return false;
+    }
+    size_t outcomeEnd = findPlainQuote(text, outcomePos + 10);
+    if(outcomeEnd == std::string_view::npos){
+        return false;
+    }
+
+    sn.action = text.substr(actionPos + 9, actionEnd - (actionPos + 9));
+    sn.outcome = text.substr(outcomePos + 10, outcomeEnd - (outcomePos + 10));
+    return true;
+}
+
+void encodeBinary(std::string &out, const StoryNodeView &sn) {
+    writeLengthPrefixed(out, sn.action);
+    writeLengthPrefixed(out, sn.outcome);
+}
+
+void decodeBinary(const char *&cursor, const char *end, StoryNodeView &sn) {
+    sn.action = readLengthPrefixed(cursor, end);
+    sn.outcome = readLengthPrefixed(cursor, end);
+}
+
+std::ostream& operator <<(std::ostream &os, const InternedStoryNode &sn) {
+    os << "action: \"";
+    writeEscaped(os, sn.action);
+    os << "\" outcome: \"";
+    writeEscaped(os, sn.outcome);
+    os << "\"";
+    return os;
+}
 
-    size_t outcomePos = buffer.find("outcome: \"", actionEnd);
-    size_t outcomeEnd = buffer.find("\"", outcomePos + 10);
-    sn.outcome = buffer.substr(outcomePos + 10, outcomeEnd - (outcomePos + 10));
+std::istream& operator >>(std::istream &is, InternedStoryNode &) {
+    is.setstate(std::ios::failbit);
     return is;
 }
\ No newline at end of file
@@ -4,12 +4,13 @@
 #include <cctype>
 #include <iostream>
 #include <string>
+#include <string_view>
 
 struct StoryNode{
     std::string action =" "; // default values for these strings.
     std::string outcome = " ";
 
-    bool operator ==(const StoryNode &sn ){
+    bool operator ==(const StoryNode &sn ) const {
         return action == sn.action && outcome == sn.outcome;
     }
 };
@@ -18,4 +19,71 @@ std::ostream& operator <<(std::ostream &os, const StoryNode &sn);
 
 std::istream& operator >>(std::istream &is, StoryNode &sn);
 
+// Fast path used by Tree::deserialize: parses the "action: \"...\" outcome: \"...\"" form straight
+// from a view, without a stream or temporary strings. Backslash-escaped quotes are supported.
+bool parse(std::string_view text, StoryNode &sn);
+
+// Binary payload used by Tree::serializeBinary: length-prefixed action, then length-prefixed outcome.
+void encodeBinary(std::string &out, const StoryNode &sn);
+
+void decodeBinary(const char *&cursor, const char *end, StoryNode &sn);
+
+// Non-owning StoryNode whose action and outcome point into an external buffer,
+// such as a memory-mapped story file. The buffer must outlive the view. Like StoryNode,
+// the views hold unescaped text; << escapes it again.
+struct StoryNodeView{
+    std::string_view action = " ";
+    std::string_view outcome = " ";
+
+    // Views cannot be rebuilt from a stream, so Tree skips its round-trip check.
+    static constexpr bool skip_compatible_check = true;
+
+    bool operator ==(const StoryNodeView &sn ) const {
+        return action == sn.action && outcome == sn.outcome;
+    }
+
+    StoryNode toStoryNode() const {
+        return StoryNode{std::string(action), std::string(outcome)};
+    }
+};
+
+std::ostream& operator <<(std::ostream &os, const StoryNodeView &sn);
+
+// Always fails; a view has nowhere to keep text read from a stream. Use parseView instead.
+std::istream& operator >>(std::istream &is, StoryNodeView &sn);
+
+// Parses the "action: \"...\" outcome: \"...\"" form, pointing sn at the text. Returns false if malformed,
+// or if a field contains escape sequences, since its unescaped text does not exist in the buffer.
+bool parseView(std::string_view text, StoryNodeView &sn);
+
+void encodeBinary(std::string &out, const StoryNodeView &sn);
+
+void decodeBinary(const char *&cursor, const char *end, StoryNodeView &sn);
+
+// StoryNode whose action and outcome are interned in a StringPool (see StringPool.h), so text
+// repeated across nodes is stored once. Equal text from one pool is always the same pooled copy,
+// which lets == compare addresses instead of characters; comparing nodes from different pools is
+// meaningless. The pool must outlive the node, e.g. by being retained by the tree.
+struct InternedStoryNode{
+    std::string_view action = " ";
+    std::string_view outcome = " ";
+
+    // Interned text can only be created through a pool, not rebuilt from a stream.
+    static constexpr bool skip_compatible_check = true;
+
+    bool operator ==(const InternedStoryNode &sn ) const {
+        return action.data() == sn.action.data() && action.size() == sn.action.size() &&
+               outcome.data() == sn.outcome.data() && outcome.size() == sn.outcome.size();
+    }
+
+    StoryNode toStoryNode() const {
+        return StoryNode{std::string(action), std::string(outcome)};
+    }
+};
+
+std::ostream& operator <<(std::ostream &os, const InternedStoryNode &sn);
+
+// Always fails, like StoryNodeView's; interned trees are built by internStoryline or loadStorylineInterned.
+std::istream& operator >>(std::istream &is, InternedStoryNode &sn);
+
 #endif // STORYNODE_H
\ No newline at end of file
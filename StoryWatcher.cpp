@@ -0,0 +1,75 @@
+#include <iostream>
+#include <system_error>
+#include <utility>
+
+#include "StoryWatcher.h"
+
+StoryWatcher::StoryWatcher(std::filesystem::path filePath, std::chrono::milliseconds interval, ReloadHandler onReload)
+    : filePath(std::move(filePath)), interval(interval), onReload(std::move(onReload)) {
+    journalFile = this->filePath;
+    journalFile += ".journal";
+    std::atomic_store(&story, Story(std::make_shared<const FrozenTree<StoryNode>>()));
+    reloadNow();
+    watcher = std::thread(&StoryWatcher::watch, this);
+}
+
+StoryWatcher::~StoryWatcher() {
+    {
+        std::lock_guard<std::mutex> lock(stopMutex);
+        stopping = true;
+    }
+    stopSignal.notify_one();
+    watcher.join();
+}
+
+StoryWatcher::FileStamp StoryWatcher::stamp(const std::filesystem::path& filePath) {
+    std::error_code error;
+    FileStamp result;
+    result.modified = std::filesystem::last_write_time(filePath, error);
+    if (error) {
+        return result;
+    }
+    result.size = std::filesystem::file_size(filePath, error);
+    result.exists = !error;
+    return result;
+}
+
+bool StoryWatcher::reloadNow() {
+    std::lock_guard<std::mutex> lock(reloadMutex);
+    FileStamp file = stamp(filePath);
+    FileStamp journal = stamp(journalFile);
+    if (checked && file == fileSeen && journal == journalSeen) {
+        return false;
+    }
+    // remembered even if loading fails, so a broken file is reported once rather than every interval
+    checked = true;
+    fileSeen = file;
+    journalSeen = journal;
+    if (!file.exists) {
+        std::cerr << "Unable to open file" << std::endl;
+        return false;
+    }
+
+    // the whole parse happens here, before anything is published
+    StoryResult<Tree<StoryNode>> loaded = tryLoadStoryline(filePath);
+    if (!loaded) {
+        std::cerr << "Error: " << loaded.status.message << std::endl;
+        return false;
+    }
+    Story next = std::make_shared<const FrozenTree<StoryNode>>(std::move(loaded.value).freeze());
+    std::atomic_store(&story, next);
+    published.fetch_add(1);
+    if (onReload) {
+        onReload(next);
+    }
+    return true;
+}
+
+void StoryWatcher::watch() {
+    std::unique_lock<std::mutex> lock(stopMutex);
+    while (!stopSignal.wait_for(lock, interval, [this] { return stopping; })) {
+        lock.unlock();
+        reloadNow();
+        lock.lock();
+    }
+}
\ No newline at end of file
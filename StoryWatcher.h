@@ -0,0 +1,105 @@
+#ifndef STORYWATCHER_H
+#define STORYWATCHER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "FrozenTree.h"
+#include "StoryNode.h"
+#include "utils.h"
+
+/**
+ * @brief Keeps a storyline loaded and reloads it whenever its file changes.
+ * 
+ * The storyline is loaded once up front, then a background thread checks the
+ * file (and its journal, see saveStorylineIncremental) for a new modification
+ * time or size. A changed file is parsed and frozen on that thread, and the
+ * new snapshot is published atomically: readers calling current() get either
+ * the old or the new version, never a partial one, and never wait on a parse.
+ * A version stays alive for as long as anyone holds it.
+ * 
+ * A file that fails to load (for example, one caught half written) is
+ * reported and skipped; the previous version stays current until the file
+ * changes again. Writers should replace the file with a rename, as
+ * saveStorylineIncremental does, so a reload only ever sees complete files.
+ */
+class StoryWatcher {
+public:
+    using Story = std::shared_ptr<const FrozenTree<StoryNode>>;
+    using ReloadHandler = std::function<void(const Story&)>;
+
+    /**
+     * @brief Loads the storyline and starts watching its file.
+     * 
+     * @param filePath storyline to load and watch
+     * @param interval time between checks of the file
+     * @param onReload called on the watcher thread with every newly published version, e.g. SessionEngine::publish
+     */
+    StoryWatcher(std::filesystem::path filePath, std::chrono::milliseconds interval, ReloadHandler onReload = {});
+
+    // Stops the watcher thread; a reload in progress finishes first.
+    ~StoryWatcher();
+
+    StoryWatcher(const StoryWatcher&) = delete;
+    StoryWatcher& operator=(const StoryWatcher&) = delete;
+
+    /**
+     * @brief Gets the latest successfully loaded version.
+     * 
+     * @return Story an empty tree if the file has never loaded
+     */
+    Story current() const { return std::atomic_load(&story); }
+
+    /**
+     * @brief Number of versions published so far, counting the initial load.
+     */
+    std::uint64_t version() const noexcept { return published.load(); }
+
+    /**
+     * @brief Checks the file right away instead of waiting for the next interval.
+     * 
+     * @return bool true if a new version was published
+     */
+    bool reloadNow();
+
+private:
+    // What a file looked like when it was last checked.
+    struct FileStamp {
+        std::filesystem::file_time_type modified{};
+        std::uintmax_t size = 0;
+        bool exists = false;
+
+        bool operator==(const FileStamp& other) const {
+            return exists == other.exists && modified == other.modified && size == other.size;
+        }
+    };
+
+    static FileStamp stamp(const std::filesystem::path& filePath);
+    void watch();
+
+    std::filesystem::path filePath;
+    std::filesystem::path journalFile;
+    std::chrono::milliseconds interval;
+    ReloadHandler onReload;
+
+    Story story; // only accessed through std::atomic_load/atomic_store
+    std::atomic<std::uint64_t> published{0};
+
+    std::mutex reloadMutex; // serializes reloads between the watcher thread and reloadNow
+    FileStamp fileSeen, journalSeen;
+    bool checked = false; // whether the stamps above have been taken yet
+
+    std::mutex stopMutex;
+    std::condition_variable stopSignal;
+    bool stopping = false;
+    std::thread watcher;
+};
+
+#endif // STORYWATCHER_H
\ No newline at end of file
@@ -0,0 +1,35 @@
+#include <cstring>
+
+#include "StringPool.h"
+
+StringPool::StringPool(std::size_t blockSize) : blockSize(blockSize) {}
+
+std::string_view StringPool::intern(std::string_view text) {
+    auto found = strings.find(text);
+    if (found != strings.end()) {
+        return *found;
+    }
+
+    char* copy;
+    if (text.size() > blockSize) {
+        // too big to pack; a dedicated block leaves the current one open for short strings
+        blocks.push_back(std::make_unique<char[]>(text.size()));
+        copy = blocks.back().get();
+    } else {
+        if (!current || blockSize - blockUsed < text.size()) {
+            blocks.push_back(std::make_unique<char[]>(blockSize));
+            current = blocks.back().get();
+            blockUsed = 0;
+        }
+        copy = current + blockUsed;
+        blockUsed += text.size();
+    }
+    if (!text.empty()) {
+        std::memcpy(copy, text.data(), text.size());
+    }
+
+    bytes += text.size();
+    std::string_view pooled(copy, text.size());
+    strings.insert(pooled);
+    return pooled;
+}
\ No newline at end of file
@@ -0,0 +1,59 @@
+#ifndef STRINGPOOL_H
+#define STRINGPOOL_H
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * @brief Deduplicating store for immutable strings.
+ * 
+ * Each distinct string is copied once into large, never-moving blocks, and
+ * every request for the same text returns a view of that one copy. Views
+ * stay valid for the lifetime of the pool, so two views of interned text
+ * are equal exactly when they point at the same bytes.
+ * 
+ * @attention Not thread-safe; avoid concurrent calls to intern.
+ */
+class StringPool {
+public:
+    /**
+     * @brief Creates an empty pool.
+     * 
+     * @param blockSize bytes allocated at a time; longer strings get a block of their own
+     */
+    explicit StringPool(std::size_t blockSize = 64 * 1024);
+
+    StringPool(const StringPool&) = delete;
+    StringPool& operator=(const StringPool&) = delete;
+
+    /**
+     * @brief Returns the pooled copy of some text, adding it on first use.
+     * 
+     * @param text text to intern; need not outlive the call
+     * @return std::string_view view of the pooled copy, valid as long as the pool
+     */
+    std::string_view intern(std::string_view text);
+
+    /**
+     * @brief Number of distinct strings in the pool.
+     */
+    std::size_t size() const noexcept { return strings.size(); }
+
+    /**
+     * @brief Bytes of text held, counting each distinct string once.
+     */
+    std::size_t textBytes() const noexcept { return bytes; }
+
+private:
+    std::size_t blockSize;
+    std::vector<std::unique_ptr<char[]>> blocks;
+    std::size_t blockUsed = 0; // bytes taken in the block new strings are packed into
+    char* current = nullptr;   // that block, or nullptr before the first one
+    std::unordered_set<std::string_view> strings; // views of the pooled copies
+    std::size_t bytes = 0;
+};
+
+#endif // STRINGPOOL_H
\ No newline at end of file
@@ -0,0 +1,175 @@
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+#include "ThreadPool.h"
+
+// Which pool and worker the current thread belongs to, so tasks can submit to their own deque.
+static thread_local const ThreadPool* currentPool = nullptr;
+static thread_local size_t currentWorker = 0;
+// Pool whose task the current thread is running, which includes tasks run while helping a wait.
+static thread_local const ThreadPool* runningPool = nullptr;
+
+ThreadPool::ThreadPool(unsigned threadCount) {
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    workers.reserve(threadCount);
+    for (unsigned i = 0; i < threadCount; ++i) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+    // start the threads only once every worker exists, since they steal from each other
+    for (size_t i = 0; i < workers.size(); ++i) {
+        workers[i]->thread = std::thread(&ThreadPool::run, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        stopping = true;
+    }
+    taskReady.notify_all();
+    for (auto& worker : workers) {
+        worker->thread.join();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    size_t index = currentPool == this ? currentWorker
+                                       : nextWorker.fetch_add(1, std::memory_order_relaxed) % workers.size();
+    pending.fetch_add(1);
+    {
+        std::lock_guard<std::mutex> lock(workers[index]->mutex);
+        workers[index]->tasks.push_back(std::move(task));
+        queued.fetch_add(1);
+    }
+    // taking the lock orders the increment before any worker re-checks it, so no wake-up is lost
+    { std::lock_guard<std::mutex> lock(stateMutex); }
+    taskReady.notify_one();
+    // waiters sleep while nothing is queued; wake them so they can help with the new task
+    progress.notify_all();
+}
+
+void ThreadPool::notifyProgress() {
+    { std::lock_guard<std::mutex> lock(stateMutex); }
+    progress.notify_all();
+}
+
+// Runs queued tasks on the calling thread until count drops to zero, sleeping while there are none.
+void ThreadPool::helpWhilePending(const std::atomic<size_t>& count) {
+    size_t home = currentPool == this ? currentWorker : 0;
+    while (count.load() > 0) {
+        if (!runOne(home)) {
+            std::unique_lock<std::mutex> lock(stateMutex);
+            progress.wait(lock, [&] { return count.load() == 0 || queued.load() > 0; });
+        }
+    }
+}
+
+void ThreadPool::wait() {
+    if (currentPool == this || runningPool == this) {
+        throw std::logic_error("ThreadPool::wait called from one of its own tasks; use a TaskGroup");
+    }
+    helpWhilePending(pending);
+    std::exception_ptr error;
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        std::swap(error, firstError);
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+// Runs one task, preferring the newest in the home deque, then the oldest in any other.
+bool ThreadPool::runOne(size_t home) {
+    std::function<void()> task;
+    for (size_t offset = 0; offset < workers.size() && !task; ++offset) {
+        Worker& victim = *workers[(home + offset) % workers.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.tasks.empty()) {
+            continue;
+        }
+        if (offset == 0) {
+            task = std::move(victim.tasks.back());
+            victim.tasks.pop_back();
+        } else {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+        }
+        queued.fetch_sub(1);
+    }
+    if (!task) {
+        return false;
+    }
+
+    const ThreadPool* outerPool = runningPool;
+    runningPool = this;
+    try {
+        task();
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        if (!firstError) {
+            firstError = std::current_exception();
+        }
+    }
+    runningPool = outerPool;
+    if (pending.fetch_sub(1) == 1) {
+        notifyProgress();
+    }
+    return true;
+}
+
+ThreadPool::TaskGroup::~TaskGroup() {
+    // the tasks refer to this group, so they must finish first; their errors go unreported
+    pool.helpWhilePending(pending);
+}
+
+void ThreadPool::TaskGroup::submit(std::function<void()> task) {
+    pending.fetch_add(1);
+    // a waiter may return and destroy the group as soon as pending reaches zero, so nothing
+    // reachable through `this` is touched after the decrement
+    pool.submit([this, pool = &pool, task = std::move(task)]() mutable {
+        try {
+            task();
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if (!firstError) {
+                firstError = std::current_exception();
+            }
+        }
+        // the task's captures may refer to the waiter's frame too
+        task = nullptr;
+        if (pending.fetch_sub(1) == 1) {
+            pool->notifyProgress();
+        }
+    });
+}
+
+void ThreadPool::TaskGroup::wait() {
+    pool.helpWhilePending(pending);
+    std::exception_ptr error;
+    {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        std::swap(error, firstError);
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+void ThreadPool::run(size_t index) {
+    currentPool = this;
+    currentWorker = index;
+    while (true) {
+        if (runOne(index)) {
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(stateMutex);
+        taskReady.wait(lock, [this] { return stopping || queued.load() > 0; });
+        if (stopping && queued.load() == 0) {
+            return;
+        }
+    }
+}
\ No newline at end of file
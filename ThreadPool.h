@@ -0,0 +1,125 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Fixed set of worker threads that share work by stealing it.
+ * 
+ * Every worker owns a deque of tasks. A worker takes its own tasks from the
+ * back, newest first, so work it has just split off stays on the same core;
+ * once its deque is empty it steals the oldest task from the front of another
+ * worker's deque. Tasks submitted from a worker go to that worker's deque,
+ * and tasks submitted from any other thread are dealt out round-robin.
+ * 
+ * A TaskGroup tracks just the tasks submitted through it: its wait() blocks
+ * until those have finished, running queued tasks on the calling thread in
+ * the meantime, and rethrows the first exception one of them threw. Groups
+ * may be waited on from inside pool tasks, so parallel work can be nested.
+ * The pool-wide wait() does the same for every task, and so may only be
+ * called from outside the pool.
+ */
+class ThreadPool {
+public:
+    /**
+     * @brief Starts the worker threads.
+     * 
+     * @param threadCount number of workers; 0 uses one per hardware thread
+     */
+    explicit ThreadPool(unsigned threadCount = 0);
+
+    /**
+     * @brief Finishes every queued task, then joins the workers.
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Queues a task to run on one of the workers.
+     * 
+     * @param task callable to run once
+     */
+    void submit(std::function<void()> task);
+
+    /**
+     * @brief Blocks until every submitted task has finished.
+     * 
+     * @throw std::logic_error If called from one of this pool's tasks, which would wait on itself.
+     * @throw Rethrows the first exception thrown by a task submitted directly to the pool since the last wait.
+     */
+    void wait();
+
+    /**
+     * @brief A set of tasks that can be waited on independently of the rest of the pool.
+     * 
+     * The group must outlive its tasks; the destructor waits for any still running.
+     */
+    class TaskGroup {
+    public:
+        explicit TaskGroup(ThreadPool& pool) noexcept : pool(pool) {}
+        ~TaskGroup();
+
+        TaskGroup(const TaskGroup&) = delete;
+        TaskGroup& operator=(const TaskGroup&) = delete;
+
+        /**
+         * @brief Queues a task on the pool as part of this group.
+         * 
+         * @param task callable to run once
+         */
+        void submit(std::function<void()> task);
+
+        /**
+         * @brief Blocks until every task of this group has finished, helping to run queued tasks.
+         * 
+         * @throw Rethrows the first exception thrown by one of this group's tasks since the last wait.
+         */
+        void wait();
+
+    private:
+        ThreadPool& pool;
+        std::atomic<size_t> pending{0}; // tasks of this group submitted but not finished
+        std::mutex errorMutex;
+        std::exception_ptr firstError;
+    };
+
+    /**
+     * @brief Number of worker threads.
+     */
+    unsigned size() const noexcept { return static_cast<unsigned>(workers.size()); }
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+        std::thread thread;
+    };
+
+    bool runOne(size_t home);
+    void run(size_t index);
+    void helpWhilePending(const std::atomic<size_t>& count);
+    void notifyProgress();
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::mutex stateMutex;
+    std::condition_variable taskReady; // signalled when a task is queued or the pool stops
+    std::condition_variable progress;  // signalled when a task is queued, or the pool or a group runs out of tasks
+    std::atomic<size_t> queued{0};     // tasks sitting in a deque
+    std::atomic<size_t> pending{0};    // tasks submitted but not finished
+    std::atomic<size_t> nextWorker{0};
+    bool stopping = false;
+    std::exception_ptr firstError;
+};
+
+#endif // THREADPOOL_H
\ No newline at end of file
@@ -45,6 +45,8 @@
  * [X]
  * [X]
  * 
+ * Readers also accept "[X*n]" for a run of n end-of-children tokens, which
+ * `serialize(true)` writes in place of consecutive "[X]" lines.
  * 
  */
 
@@ -52,23 +54,44 @@
 #define TREE_H
 
 #include <algorithm>
-#include <functional>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
 #include <iostream>
+#include <iterator>
+#include <limits>
 #include <memory>
 #include <optional>
 #include <queue>
 #include <stack>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <sstream>
+#include <thread>
 #include <type_traits>
-#include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include "BinaryCodec.h"
+#include "BlockCompression.h"
+#include "LineScanner.h"
+#include "NodePool.h"
+#include "TreeMetrics.h"
+
 // Forward declaration of the Tree class to enable the Node class to declare it as a friend
 template <typename T>
 class Tree;
 
+// Forward declaration of ArenaTree so Tree can share its serialization helpers with it
+template <typename T>
+class ArenaTree;
+
+// Forward declaration of FrozenTree, the read-only snapshot returned by Tree::freeze (see FrozenTree.h)
+template <typename T>
+class FrozenTree;
+
 // Base template for has_out_stream_operator; assumes T does not have a << operator.
 template <typename T, typename = void>
 struct has_out_stream_operator : std::false_type {};
@@ -95,6 +118,16 @@ struct has_stream_operators {
     static constexpr bool value = has_out_stream_operator<T>::value && has_in_stream_operator<T>::value;
 };
 
+// Base template for has_string_view_parse; assumes T has no parse(std::string_view, T&) fast path.
+template <typename T, typename = void>
+struct has_string_view_parse : std::false_type {};
+
+// Specialization of has_string_view_parse; true if a bool parse(std::string_view, T&) overload exists.
+template <typename T>
+struct has_string_view_parse<T,
+    std::void_t<decltype(parse(std::declval<std::string_view>(), std::declval<T&>()))>>
+    : std::true_type {};
+
 // Base template for has_default_constructor; assumes T does not have a default constructor.
 template<typename T, typename = void>
 struct has_default_constructor : std::false_type {};
@@ -111,6 +144,44 @@ struct has_equality_operator : std::false_type {};
 template<typename T>
 struct has_equality_operator<T, std::void_t<decltype(std::declval<T>() == std::declval<T>())>> : std::true_type {};
 
+// Base template for skips_compatible_check; assumes T wants the round-trip check.
+// Trusted types that can't declare the member below may opt out by specializing this
+// template instead, e.g. `template<> struct skips_compatible_check<Vec2> : std::true_type {};`.
+template<typename T, typename = void>
+struct skips_compatible_check : std::false_type {};
+
+// Specialization of skips_compatible_check; true if T declares `static constexpr bool skip_compatible_check = true`.
+template<typename T>
+struct skips_compatible_check<T, std::void_t<decltype(T::skip_compatible_check)>>
+    : std::bool_constant<T::skip_compatible_check> {};
+
+/**
+ * @brief Stream buffer that appends everything written to it to a std::string.
+ * 
+ * Lets stream-based serialization write into a caller-owned string, so a
+ * buffer reused across calls stops allocating once it is large enough.
+ */
+class StringOutputBuffer : public std::streambuf {
+public:
+    explicit StringOutputBuffer(std::string& out) noexcept : out(out) {}
+
+protected:
+    int_type overflow(int_type ch) override {
+        if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+            out.push_back(traits_type::to_char_type(ch));
+        }
+        return traits_type::not_eof(ch);
+    }
+
+    std::streamsize xsputn(const char* bytes, std::streamsize count) override {
+        out.append(bytes, static_cast<size_t>(count));
+        return count;
+    }
+
+private:
+    std::string& out;
+};
+
 /**
  * @brief Represents a tree node.
  * 
@@ -143,7 +214,48 @@ private:
      */
     Node(T value, Node* parent = nullptr) noexcept : value(std::move(value)), parent(parent) {}
 
+public:
+    /**
+     * @brief Destroys the node's subtree without recursing.
+     * 
+     * Left to the default, each child's destructor would destroy its own
+     * children in turn, using one stack frame per level, which overflows on
+     * long chains. Instead every descendant is detached onto an explicit stack
+     * first, so each node is destroyed with no children left.
+     */
+    ~Node() {
+        std::vector<std::unique_ptr<Node>> pending = std::move(children);
+        while (!pending.empty()) {
+            std::unique_ptr<Node> node = std::move(pending.back());
+            pending.pop_back();
+            for (auto& child : node->children) {
+                pending.push_back(std::move(child));
+            }
+            node->children.clear();
+        }
+    }
+
+    /**
+     * @brief Allocates nodes from a NodePool shared by every node of the same size (see NodePool.h).
+     */
+    static void* operator new(std::size_t size) {
+        if (NODE_POOL_ENABLED && size == sizeof(Node)) {
+            return NodePool<sizeof(Node), alignof(Node)>::allocate();
+        }
+        return ::operator new(size);
+    }
+
+    static void operator delete(void* pointer, std::size_t size) noexcept {
+        if (NODE_POOL_ENABLED && size == sizeof(Node)) {
+            NodePool<sizeof(Node), alignof(Node)>::deallocate(pointer);
+            return;
+        }
+        ::operator delete(pointer);
+    }
+
+private:
     friend class Tree<T>; // Grants Tree exclusive access to Node's private members.
+    template <typename> friend class FrozenTree; // Reads nodes directly when taking a snapshot.
 };
 
 /**
@@ -171,18 +283,128 @@ class Tree {
     static_assert(has_default_constructor<T>::value, "Type T must have a default constructor defined.");
     static_assert(has_equality_operator<T>::value, "Type T must have an equality (==) operator defined.");
     
+    template <typename> friend class ArenaTree; // Reuses the parsing and compatibility helpers.
+    template <typename> friend class FrozenTree; // Reads the nodes directly when taking a snapshot.
+    template <typename> friend class LazyTree; // Decodes values with the same helpers.
+    friend struct TreeBenchAccess; // Lets bench/tree_benchmarks time the private linearize steps.
+
+public:
+    /**
+     * @brief Path statistics for one node, kept up to date while `annotatePaths` is enabled.
+     * 
+     * An ending is a node with no children; every count is in choices (edges).
+     */
+    struct PathStats {
+        size_t depth = 0;            // Choices from the root to this node
+        size_t endingCount = 1;      // Endings in this node's subtree; an ending counts itself
+        size_t minTurnsToEnding = 0; // Fewest choices from this node to an ending
+        size_t maxTurnsToEnding = 0; // Most choices from this node to an ending
+    };
+
 private:
     std::unique_ptr<Node<T>> root;
-    std::unordered_map<int, Node<T>*> nodeMap; // Maps node ID's to pointers for constant time access
+    std::vector<Node<T>*> nodeMap; // Indexed by node ID; nullptr marks a removed node. IDs are never reused
+    size_t liveNodeCount = 0; // Number of non-null nodeMap entries
     int nextID = 0; // Increments for each new node to ensure unique ID's
+    std::shared_ptr<const void> storage; // External buffer node values may refer into, e.g. a mapped file
+    bool journaling = false; // Whether edits are being recorded in `journal`
+    std::string journal; // Edits not yet saved, one line each; see `applyJournal` for the format
+    std::vector<Node<T>*> walkStack; // Scratch stack reused by the mutating subtree walks
+    bool annotating = false; // Whether `pathAnnotations` is being maintained
+    std::vector<PathStats> pathAnnotations; // Indexed by node ID like nodeMap; entries of removed nodes are stale
+    bool batching = false; // Whether a `batch` is being built; direct edits are refused until it commits
+
+    /**
+     * @brief Writes a node's position as child indices from the root, e.g. "/2/0".
+     * 
+     * Positions rather than IDs are journaled because IDs are renumbered every
+     * time a tree is saved and loaded again, while a position means the same
+     * node in the saved tree as in memory.
+     * 
+     * @param out Buffer to append to.
+     * @param node Node to locate; the root is written as "/".
+     */
+    static void writePath(std::string& out, const Node<T>* node) {
+        std::vector<size_t> indices;
+        for (; node->parent; node = node->parent) {
+            const auto& siblings = node->parent->children;
+            for (size_t i = 0; i < siblings.size(); ++i) {
+                if (siblings[i].get() == node) {
+                    indices.push_back(i);
+                    break;
+                }
+            }
+        }
+        if (indices.empty()) {
+            out.push_back('/');
+        }
+        for (auto itr = indices.rbegin(); itr != indices.rend(); ++itr) {
+            out.push_back('/');
+            out += std::to_string(*itr);
+        }
+    }
 
     /**
-     * @brief Assigns unique IDs to nodes within a subtree recursively.
+     * @brief Records one edit in the journal, if journaling is enabled.
+     * 
+     * @param op '=' for setRoot, '+' for appendNode, '-' for removeNode.
+     * @param node The new root, the parent appended to, or the node removed.
+     * @param value The value set or appended; nullptr for removals.
+     */
+    void recordEdit(char op, const Node<T>* node, const T* value) {
+        if (!journaling) {
+            return;
+        }
+        journal.push_back(op);
+        journal.push_back('[');
+        writePath(journal, node);
+        journal.push_back(']');
+        if (value) {
+            std::ostringstream valueStream;
+            valueStream << *value;
+            journal += ": ";
+            journal += valueStream.str();
+        }
+        journal.push_back('\n');
+    }
+
+    /**
+     * @brief Resolves a journaled position back to a node.
+     * 
+     * @param path Child indices from the root, as written by `writePath`.
+     * @return Node<T>* The node at that position.
+     * @throw std::invalid_argument If the path is malformed or doesn't exist in the tree.
+     */
+    Node<T>* resolvePath(std::string_view path) const {
+        if (!root || path.empty() || path[0] != '/') {
+            throw std::invalid_argument("Invalid journal: no node at position [" + std::string(path) + "]");
+        }
+        Node<T>* node = root.get();
+        size_t position = 1;
+        while (position < path.size()) {
+            size_t next = path.find('/', position);
+            if (next == std::string_view::npos) {
+                next = path.size();
+            }
+            size_t index = 0;
+            std::istringstream indexStream{std::string(path.substr(position, next - position))};
+            if (!(indexStream >> index) || index >= node->children.size()) {
+                throw std::invalid_argument("Invalid journal: no node at position [" + std::string(path) + "]");
+            }
+            node = node->children[index].get();
+            position = next + 1;
+        }
+        return node;
+    }
+
+    /**
+     * @brief Assigns unique IDs to nodes within a subtree, in pre-order.
      * 
      * Ensures each node, from individual to full subtrees, receives a unique identifier,
      * updating `nodeMap` to link new IDs with node pointers. This method is crucial for
      * preserving structural integrity, used when adding nodes and during deserialization
-     * to reset ID-to-node mappings.
+     * to reset ID-to-node mappings. Walks the subtree with `walkStack` rather than
+     * recursion, so depth is not limited by the call stack.
      * 
      * @param node Pointer to the root of the subtree; if nullptr, return immediately.
      */
@@ -190,11 +412,186 @@ private:
         if (!node) {
             return;
         }
-        node->ID = nextID++;
-        nodeMap[node->ID] = node;
-        // If node has children, recursively assign IDs to them
-        for (auto& child : node->children) {
-            assignIDs(child.get());
+        walkStack.clear();
+        walkStack.push_back(node);
+        while (!walkStack.empty()) {
+            Node<T>* current = walkStack.back();
+            walkStack.pop_back();
+            current->ID = nextID++;
+            // IDs are handed out sequentially, so the new ID is always the next slot
+            nodeMap.push_back(current);
+            liveNodeCount++;
+            // push children in reverse order so they are numbered left-to-right
+            for (auto itr = current->children.rbegin(); itr != current->children.rend(); ++itr) {
+                walkStack.push_back(itr->get());
+            }
+        }
+    }
+
+    /**
+     * @brief Recomputes a node's path statistics from its children's.
+     * 
+     * @param node Node whose children are already up to date.
+     * @return bool Whether the node's statistics changed.
+     */
+    bool summarizeChildren(const Node<T>* node) {
+        PathStats& stats = pathAnnotations[node->ID];
+        PathStats updated{stats.depth, 1, 0, 0};
+        if (!node->children.empty()) {
+            updated.endingCount = 0;
+            updated.minTurnsToEnding = std::numeric_limits<size_t>::max();
+            for (const auto& child : node->children) {
+                const PathStats& childStats = pathAnnotations[child->ID];
+                updated.endingCount += childStats.endingCount;
+                updated.minTurnsToEnding = std::min(updated.minTurnsToEnding, childStats.minTurnsToEnding + 1);
+                updated.maxTurnsToEnding = std::max(updated.maxTurnsToEnding, childStats.maxTurnsToEnding + 1);
+            }
+        }
+        bool changed = updated.endingCount != stats.endingCount || updated.minTurnsToEnding != stats.minTurnsToEnding ||
+                       updated.maxTurnsToEnding != stats.maxTurnsToEnding;
+        stats = updated;
+        return changed;
+    }
+
+    /**
+     * @brief Updates path statistics for a node just added as a leaf, and for its ancestors.
+     * 
+     * Ancestors are refreshed bottom-up along the parent pointers, stopping at
+     * the first one whose statistics didn't change.
+     * 
+     * @param node The new leaf.
+     */
+    void annotateLeaf(const Node<T>* node) {
+        if (!annotating) {
+            return;
+        }
+        pathAnnotations.resize(nodeMap.size());
+        size_t depth = node->parent ? pathAnnotations[node->parent->ID].depth + 1 : 0;
+        pathAnnotations[node->ID] = PathStats{depth, 1, 0, 0};
+        refreshAncestors(node->parent);
+    }
+
+    /**
+     * @brief Computes path statistics for every node of a subtree.
+     * 
+     * Depths are assigned top-down from the subtree root's parent, while the
+     * nodes are listed in pre-order, then the summaries are built bottom-up in
+     * reverse. The subtree root's ancestors are left for `refreshAncestors`.
+     * 
+     * @param node Root of the subtree; its parent, if any, must already be annotated.
+     */
+    void annotateSubtree(Node<T>* node) {
+        pathAnnotations.resize(nodeMap.size());
+        std::vector<const Node<T>*> order;
+        walkStack.clear();
+        walkStack.push_back(node);
+        while (!walkStack.empty()) {
+            Node<T>* current = walkStack.back();
+            walkStack.pop_back();
+            pathAnnotations[current->ID].depth = current->parent ? pathAnnotations[current->parent->ID].depth + 1 : 0;
+            order.push_back(current);
+            for (auto& child : current->children) {
+                walkStack.push_back(child.get());
+            }
+        }
+        for (auto itr = order.rbegin(); itr != order.rend(); ++itr) {
+            summarizeChildren(*itr);
+        }
+    }
+
+    /**
+     * @brief Takes a node out of its parent's list of children.
+     * 
+     * @param node A node with a parent.
+     * @return std::unique_ptr<Node<T>> Ownership of the node; its parent pointer is left unchanged.
+     */
+    static std::unique_ptr<Node<T>> unlinkChild(Node<T>* node) {
+        auto& siblings = node->parent->children;
+        auto itr = std::find_if(siblings.begin(), siblings.end(),
+                                [node](const std::unique_ptr<Node<T>>& child) { return child.get() == node; });
+        std::unique_ptr<Node<T>> owned = std::move(*itr);
+        siblings.erase(itr);
+        return owned;
+    }
+
+    /**
+     * @brief Refreshes path statistics from a node up to the root, stopping once nothing changes.
+     * 
+     * @param node First node whose children changed; nullptr does nothing.
+     */
+    void refreshAncestors(const Node<T>* node) {
+        while (node && summarizeChildren(node)) {
+            node = node->parent;
+        }
+    }
+
+    /**
+     * @brief Looks up a node by ID.
+     * 
+     * A bounds check and a single load; removed and never-issued IDs both yield nullptr.
+     * 
+     * @param nodeID ID of the node.
+     * @return Node<T>* The node, or nullptr if no live node has that ID.
+     */
+    Node<T>* findNode(int nodeID) const noexcept {
+        TREE_METRICS_ADD(nodeLookups, 1);
+        if (nodeID < 0 || static_cast<size_t>(nodeID) >= nodeMap.size()) {
+            TREE_METRICS_ADD(nodeLookupsOutOfRange, 1);
+            return nullptr;
+        }
+        TREE_METRICS_ADD(nodeLookupsRemoved, nodeMap[nodeID] == nullptr);
+        return nodeMap[nodeID];
+    }
+
+    /**
+     * @brief Looks up a node by ID, throwing if it doesn't exist.
+     * 
+     * @param nodeID ID of the node.
+     * @return Node<T>* The node.
+     * @throw std::invalid_argument If no live node has that ID.
+     */
+    Node<T>* checkedNode(int nodeID) const {
+        Node<T>* node = findNode(nodeID);
+        if (!node) {
+            std::stringstream errMsg;
+            errMsg << "Node with ID " << nodeID << " does not exist";
+            throw std::invalid_argument(errMsg.str());
+        }
+        return node;
+    }
+
+    /**
+     * @brief Refuses structural edits while a batch is being built, since its queued IDs assume none happen.
+     * 
+     * @throw std::logic_error If called from inside a `batch` callback.
+     */
+    void checkNotBatching() const {
+        if (batching) {
+            throw std::logic_error("The tree cannot be edited directly while a batch is being built");
+        }
+    }
+
+    /**
+     * @brief Calls a `visit` callback with whichever arguments it accepts.
+     * 
+     * @return bool False if the visitor asked to skip the node's descendants.
+     */
+    template <typename F, typename Ref>
+    static bool invokeVisitor(F& visitor, const Ref& node, size_t depth) {
+        if constexpr (std::is_invocable<F&, const Ref&, size_t>::value) {
+            if constexpr (std::is_same<std::invoke_result_t<F&, const Ref&, size_t>, bool>::value) {
+                return visitor(node, depth);
+            } else {
+                visitor(node, depth);
+                return true;
+            }
+        } else {
+            if constexpr (std::is_same<std::invoke_result_t<F&, const Ref&>, bool>::value) {
+                return visitor(node);
+            } else {
+                visitor(node);
+                return true;
+            }
         }
     }
 
@@ -253,48 +650,15 @@ private:
     /**
      * @brief Reconstructs a tree from its linearized vector representation.
      * 
-     * This static method rebuilds a tree from a linear sequence of optional values,
-     * representing node values and end-of-children tokens. It uses the end-of-children
-     * tokens to determine when to pop the current parent from the stack. This accurately
-     * recontructs the tree's original hierarchical structure.
-     * 
-     * Delinearization algorithm:
-     * 1. Create an empty tree.
-     * 2. Use a stack to track the current parent nodes.
-     * 3. Iterate over the linearized data:
-     *    - If encountering a non-empty value with no current tree, set it as the root.
-     *    - If encountering a non-empty value with an existing tree, add a new node under
-     *      the current parent, updating the stack with the new node's ID.
-     *    - If encountering an empty value, pop the current parent from the stack.
-     * 4. Return the newly formed tree.
+     * Copying counterpart of `fromLinearized` for callers that need to keep the
+     * linearized data; see `fromLinearized` for the algorithm.
      * 
      * @param linearized Linearized tree data.
      * @return Tree<T> The reconstructed tree.
      */
     static Tree<T> delinearize(const std::vector<std::optional<T>>& linearized) {
-        Tree<T> tree;
-        std::stack<int> parentIDs;
-
-        for (const auto& optValue : linearized) {
-            // Handle node value
-            if (optValue.has_value()) {
-                // Handle root node
-                if (tree.getRootID() == -1) {
-                    tree.setRoot(optValue.value());
-                    parentIDs.push(tree.getRootID());
-                // Handle the rest of the subtree's nodes
-                } else {
-                    int childID = tree.appendNode(parentIDs.top(), optValue.value());
-                    // new node becomes the current parent, so push its ID onto the stack
-                    parentIDs.push(childID);
-                }
-            // Handle end-of-children token
-            } else if (!parentIDs.empty()) {
-                // pop the parent from the stack since the end of the parent's children list has been reached
-                parentIDs.pop();
-            }
-        }
-        return tree;
+        std::vector<std::optional<T>> copy = linearized;
+        return fromLinearized(std::move(copy));
     }
 
     /**
@@ -307,9 +671,29 @@ private:
      * any of these operations are not supported as expected. If this method throws, it indicates
      * that T is incapable of being serialized and then accurately reconstructed via deserialization.
      * 
+     * The round trip runs once per type, the first time any tree of T is
+     * constructed; later calls only rethrow a cached failure. Types for which
+     * `skips_compatible_check` holds never run it at all.
+     * 
      * @throws std::invalid_argument if T lacks compatible <<, >> operators or equality operator.
      */
-    void T_compatible_check() const {
+    static void T_compatible_check() {
+        // Types such as views into external buffers opt out, since >> cannot rebuild them
+        if constexpr (!skips_compatible_check<T>::value) {
+            // thread-safe one-time initialization; an incompatible T fails the same way every time
+            static const std::exception_ptr failure = compatibilityFailure();
+            if (failure) {
+                std::rethrow_exception(failure);
+            }
+        }
+    }
+
+    /**
+     * @brief Runs the round trip behind `T_compatible_check`.
+     * 
+     * @return std::exception_ptr The std::invalid_argument describing the mismatch, or null if T is compatible.
+     */
+    static std::exception_ptr compatibilityFailure() {
         // Serialize an instance of T
         T testT = T();
         std::ostringstream testStream;
@@ -322,7 +706,7 @@ private:
 
         // Check if the original and deserialized instances are equal
         bool t_compatible = testT == testT2;
-        // Throw if T is incompatible to prevent initialization of invalid trees
+        // Report T as incompatible to prevent initialization of invalid trees
         if (!t_compatible) {
             std::stringstream errMsg;
             errMsg << "Type T has one or more of: an incompatible out-stream operator (<<), " <<
@@ -331,97 +715,942 @@ private:
                       "same string to the original T, and the equality operator correctly " <<
                       "returns true when comparing two instances of T where one is the result " <<
                       "of serializing and then deserializing the other.\n";
-            throw std::invalid_argument(errMsg.str());
+            return std::make_exception_ptr(std::invalid_argument(errMsg.str()));
         }
+        return nullptr;
     }
 
-public:
     /**
-     * @brief Initializes an empty Tree.
+     * @brief Appends a value's binary payload to a buffer.
      * 
-     * Constructs a Tree with no root, requiring `setRoot`
-     * to add the root node. This constructor is ideal 
-     * for rebuilding a tree via `delinearize`.
+     * @param out Buffer to append to.
+     * @param value Value to encode.
      */
-    Tree() {
-        T_compatible_check();
-        root = nullptr;
-    };
+    static void encodeBinaryValue(std::string& out, const T& value) {
+        if constexpr (has_binary_codec<T>::value) {
+            encodeBinary(out, value);
+        } else if constexpr (std::is_same<T, std::string>::value) {
+            writeLengthPrefixed(out, value);
+        } else {
+            std::ostringstream textStream;
+            textStream << value;
+            writeLengthPrefixed(out, textStream.str());
+        }
+    }
 
     /**
-     * @brief Constructs a Tree with a root node from an lvalue.
+     * @brief Reads a value's binary payload written by `encodeBinaryValue`.
      * 
-     * Creates a tree with a root node, copying the provided value.
-     * Suitable for when retaining the original value is necessary.
-     * 
-     * @param value The value for the root node.
+     * @param cursor Current read position; advanced past the payload.
+     * @param end One past the last readable byte.
+     * @param value Receives the decoded value.
+     * @throw std::invalid_argument If the payload is truncated or cannot be parsed.
      */
-    Tree(const T& value) {
-        T_compatible_check();
-        setRoot(value);
+    static void decodeBinaryValue(const char*& cursor, const char* end, T& value) {
+        if constexpr (has_binary_codec<T>::value) {
+            decodeBinary(cursor, end, value);
+        } else if constexpr (std::is_same<T, std::string>::value) {
+            value = std::string(readLengthPrefixed(cursor, end));
+        } else {
+            std::istringstream valueStream(std::string(readLengthPrefixed(cursor, end)));
+            if (!(valueStream >> value)) {
+                throw std::invalid_argument("Invalid binary tree: unable to parse value");
+            }
+        }
     }
 
     /**
-     * @brief Constructs a Tree with a root node from an rvalue.
+     * @brief Encodes the tree in the binary format into a buffer, handing it to a sink as it fills.
      * 
-     * Efficiently sets the root node using the provided movable
-     * value. Ideal for transferring ownership without copying.
+     * Shared by the stream and buffer overloads of `serializeBinary`. The buffer
+     * is passed to `sink` and cleared whenever it reaches `flushThreshold`; the
+     * caller handles whatever is left at the end. Only buffers that start empty
+     * may be flushed, since flushing drops everything in them.
      * 
-     * @param value The value to move as the root node.
+     * @param buffer Buffer to encode into; the tree is appended after existing contents.
+     * @param withIndex Also write the index footer.
+     * @param flushThreshold Buffer size that triggers a flush.
+     * @param sink Receives each full buffer.
      */
-    Tree(T&& value) {
-        T_compatible_check();
-        setRoot(std::move(value));
+    template <typename Sink>
+    void writeBinary(std::string& buffer, bool withIndex, size_t flushThreshold, Sink&& sink) const {
+        const size_t base = buffer.size();
+        buffer.append(BINARY_TREE_MAGIC, BINARY_TREE_MAGIC_SIZE);
+        buffer.push_back(static_cast<char>(BINARY_TREE_VERSION));
+        buffer.push_back(static_cast<char>(withIndex ? BINARY_TREE_FLAG_INDEX : 0));
+        writeVarint(buffer, liveNodeCount);
+
+        // offsets in the index are relative to the header; `flushed` counts bytes already handed to the sink
+        std::uint64_t flushed = 0;
+        auto flush = [&]() {
+            sink(std::string_view(buffer));
+            flushed += buffer.size();
+            buffer.clear();
+        };
+        std::vector<BinaryIndexEntry> index;
+        std::vector<int> parents; // pre-order position of each node's parent, for the subtree sizes
+        if (withIndex) {
+            index.reserve(liveNodeCount);
+            parents.reserve(liveNodeCount);
+        }
+
+        // stack of (node, pre-order position of its parent)
+        std::stack<std::pair<const Node<T>*, int>> stack;
+        if (root) {
+            stack.push({root.get(), -1});
+        }
+        // writes one node's payload, returning its pre-order position
+        auto writePayload = [&](const Node<T>* node, int parent) {
+            int position = static_cast<int>(index.size());
+            if (withIndex) {
+                index.push_back({flushed + buffer.size() - base, static_cast<std::uint32_t>(node->children.size()), 1});
+                parents.push_back(parent);
+            }
+            encodeBinaryValue(buffer, node->value);
+            if (buffer.size() >= flushThreshold) {
+                flush();
+            }
+            return position;
+        };
+        while (!stack.empty()) {
+            auto [current, parent] = stack.top();
+            stack.pop();
+
+            // a run of single-child nodes becomes one chain record, ending at the first node that isn't one
+            if (std::uint64_t length = chainLength(current)) {
+                writeChainHeader(buffer, length);
+                for (; length > 0; --length) {
+                    parent = writePayload(current, parent);
+                    current = current->children.front().get();
+                }
+            }
+            writeRecordHeader(buffer, current->children.size());
+            int position = writePayload(current, parent);
+            // push children in reverse order so they are written left-to-right
+            for (auto itr = current->children.rbegin(); itr != current->children.rend(); ++itr) {
+                stack.push({itr->get(), position});
+            }
+        }
+
+        if (withIndex) {
+            // children follow their parent in pre-order, so one backwards pass sums the subtree sizes
+            for (size_t position = index.size(); position-- > 1;) {
+                index[parents[position]].subtreeSize += index[position].subtreeSize;
+            }
+            std::uint64_t indexOffset = flushed + buffer.size() - base;
+            std::uint64_t checksum = FNV1A_OFFSET_BASIS;
+            for (const auto& entry : index) {
+                size_t entryStart = buffer.size();
+                writeBinaryIndexEntry(buffer, entry);
+                checksum = fnv1a64(std::string_view(buffer).substr(entryStart), checksum);
+                if (buffer.size() >= flushThreshold) {
+                    flush();
+                }
+            }
+            writeBinaryIndexTrailer(buffer, indexOffset, checksum);
+        }
     }
-    
+
     /**
-     * @brief Sets the tree's root node.
+     * @brief Counts the nodes from `node` down that each have exactly one child.
      * 
-     * Initializes the tree with a specified value for the root.
-     * Intended for use with an empty tree to start building its
-     * structure. The method assigns a unique ID to the root and 
-     * updates the nodeMap.
-     * 
-     * @param value The value for the root node.
-     * @return int The ID of the root node.
-     * @throw std::logic_error If attempting to set the root on a non-empty tree.
+     * @param node First node of the run.
+     * @return std::uint64_t Length of the chain record starting at `node`, or 0 if it doesn't have one child.
      */
-    int setRoot(T value) {
-        if (root) {
-            throw std::logic_error("The root node has already been set");
+    static std::uint64_t chainLength(const Node<T>* node) noexcept {
+        std::uint64_t length = 0;
+        for (; node->children.size() == 1; node = node->children.front().get()) {
+            ++length;
         }
-        // instantiate before passing to unique_ptr because make_unique doesn't have access to node constructor
-        Node<T>* rootNode = new Node<T>(std::move(value));
-        root.reset(rootNode);
-        assignIDs(root.get());
-        return root->ID;
+        return length;
     }
 
     /**
-     * @brief Adds a child node under a specified parent.
+     * @brief Writes pending end-of-children tokens, one "[X]" line each or one "[X*n]" line for a run.
      * 
-     * Appends a new node with the provided value as a child to the 
-     * given parent node, updating the nodeMap with a unique ID for
-     * the new node. Returns the ID of the new node for reference.
-     * 
-     * @param parentID ID of the parent node.
-     * @param value Value for the new node.
-     * @return int ID of the new node.
-     * @throw std::invalid_argument If the parent node ID is invalid.
+     * @param os Stream to write to.
+     * @param count Number of tokens to write; reset to 0.
+     * @param compactRuns Write a run of two or more tokens as one "[X*n]" line.
      */
-    int appendNode(int parentID, T value) {
-        auto parentNodeItr = nodeMap.find(parentID);
-        if (parentNodeItr == nodeMap.end()) {
-            std::stringstream errMsg;
-            errMsg << "Parent node with ID " << parentID << " does not exist.";
-            throw std::invalid_argument(errMsg.str());
+    static void writeEndOfChildren(std::ostream& os, size_t& count, bool compactRuns) {
+        if (compactRuns && count > 1) {
+            os << "[X*" << count << "]\n";
+        } else {
+            for (; count > 0; --count) {
+                os << "[X]\n";
+            }
         }
+        count = 0;
+    }
 
-        Node<T>* parentNode = parentNodeItr->second;
-
-        // instantiate before passing to unique_ptr because make_unique doesn't have acccess to node constructor
+    /**
+     * @brief Parses the value part of a serialized node line.
+     * 
+     * @param valuePart Text following the "[n]: " prefix.
+     * @param value Receives the parsed value.
+     * @return bool True if the value was parsed.
+     */
+    static bool parseValue(std::string_view valuePart, T& value) {
+        // Compile time check to handle strings differently for serialization
+        // Since istream stops at the first whitespace; We want to capture the entire line
+        if constexpr (std::is_same<T, std::string>::value) {
+            value.assign(valuePart.data(), valuePart.size());
+            return true;
+        // Types with a parse(std::string_view, T&) overload skip the stream entirely
+        } else if constexpr (has_string_view_parse<T>::value) {
+            return parse(valuePart, value);
+        // Handle fundamental types
+        // And custom types that implement the << and >> operators
+        } else {
+            std::istringstream valueStream{std::string(valuePart)};
+            return static_cast<bool>(valueStream >> value);
+        }
+    }
+
+    /**
+     * @brief Parses one contiguous run of serialized lines into linearized values.
+     * 
+     * Structure is not validated here; the caller has already checked the
+     * end-of-children token balance for the range.
+     * 
+     * @param text Complete lines of a serialized tree.
+     * @param linearized Receives the values and end-of-children tokens, in order.
+     * @throw std::invalid_argument If a line is malformed or a value cannot be parsed.
+     */
+    static void parseLines(std::string_view text, std::vector<std::optional<T>>& linearized) {
+        LineScanner scanner(text);
+        std::vector<LineRecord> records;
+        while (scanner.scan(records)) {
+            TREE_METRICS_ADD(linesParsed, records.size());
+            for (const auto& record : records) {
+                if (record.kind == LineRecord::EndOfChildren) {
+                    linearized.insert(linearized.end(), record.count, std::nullopt);
+                    continue;
+                }
+                T value;
+                if (record.kind == LineRecord::Malformed) {
+                    throw std::invalid_argument("Invalid tree serialization: malformed line: " + std::string(record.line));
+                }
+                if (!parseValue(record.value(), value)) {
+                    throw std::invalid_argument("Invalid tree serialization: unable to parse value: " + std::string(record.line));
+                }
+                linearized.push_back(std::move(value));
+            }
+        }
+    }
+
+    /**
+     * @brief Parses an in-memory text serialization, throwing on the first error.
+     * 
+     * Lines are split and classified in bulk by LineScanner, and values are
+     * parsed straight from views into the buffer.
+     * 
+     * @param serialized Serialized tree text.
+     * @param linearized Receives the linearized tree data; holds everything parsed before an error.
+     * @throw std::invalid_argument If a line is malformed or the end-of-children tokens don't balance.
+     */
+    static void parseText(std::string_view serialized, std::vector<std::optional<T>>& linearized) {
+        TREE_METRICS_TIME(parseLatency);
+        TREE_METRICS_ADD(bytesParsed, serialized.size());
+        LineScanner scanner(serialized);
+        std::vector<LineRecord> records;
+        int nodeCount = 0, eocTokenCount = 0, lineNumber = 0;
+        std::stringstream errMsg;
+
+        while (scanner.scan(records)) {
+            TREE_METRICS_ADD(linesParsed, records.size());
+            for (const auto& record : records) {
+                ++lineNumber;
+                // Handle end-of-children tokens
+                if (record.kind == LineRecord::EndOfChildren) {
+                    // Invalid hierarchical structure - too many end-of-children tokens
+                    if (record.count > static_cast<size_t>(nodeCount - eocTokenCount)) {
+                        errMsg << "Invalid tree serialization: too many end-of-children tokens\n"
+                            << "A valid serialization should have one end-of-children token for every node.\n"
+                            << "Occurred during line " << lineNumber << " of the serialization.\n";
+                        throw std::invalid_argument(errMsg.str());
+                    }
+                    linearized.insert(linearized.end(), record.count, std::nullopt);
+                    eocTokenCount += static_cast<int>(record.count);
+                // Handle node values
+                } else if (record.kind == LineRecord::NodeValue) {
+                    T value;
+                    if (parseValue(record.value(), value)) {
+                        linearized.push_back(std::move(value));
+                        nodeCount++;
+                    } else {
+                        errMsg << "Invalid tree serialization: unable to parse value\n"
+                            << "Unable to parse value from line while deserializing tree: " << record.line << "\n"
+                            << "Occurred during line " << lineNumber << " of the serialization.\n";
+                        throw std::invalid_argument(errMsg.str());
+                    }
+                // Invalid line format
+                } else {
+                    errMsg << "Invalid tree serialization: invalid line format\n"
+                        << "Malformed line detected while deserializing tree: " << record.line << "\n"
+                        << "Expected format: '[n]: value' for nodes or '[X]' / '[X*n]' for end-of-children tokens.\n"
+                        << "Occurred during line " << lineNumber << " of the serialization.\n";
+                    throw std::invalid_argument(errMsg.str());
+                }
+            }
+        }
+
+        // Invalid hierarchical structure - too few end-of-children tokens
+        if (nodeCount != eocTokenCount) {
+            errMsg << "Invalid tree serialization: Too few end-of-children tokens\n"
+                << "A valid serialization should have one end-of-children token for every node.\n";
+            throw std::invalid_argument(errMsg.str());
+        }
+    }
+
+    /**
+     * @brief Decodes a binary serialization, throwing on the first error.
+     * 
+     * Child counts are converted back into end-of-children tokens so both formats
+     * share `fromLinearized`.
+     * 
+     * @param serialized Binary serialized tree data.
+     * @param linearized Receives the linearized tree data; holds everything decoded before an error.
+     * @throw std::invalid_argument If the data is malformed or truncated.
+     */
+    static void parseBinary(std::string_view serialized, std::vector<std::optional<T>>& linearized) {
+        TREE_METRICS_TIME(parseLatency);
+        TREE_METRICS_ADD(bytesParsed, serialized.size());
+        const char* cursor = serialized.data();
+        const char* end = cursor + serialized.size();
+
+        bool chains = checkBinaryTreeHeader(serialized);
+        cursor += BINARY_TREE_HEADER_SIZE;
+
+        std::uint64_t nodeCount = readVarint(cursor, end);
+        // every node needs at least two bytes, or one inside a chain, so this also guards the reservation
+        if (nodeCount > static_cast<std::uint64_t>(end - cursor) / (chains ? 1 : 2)) {
+            throw std::invalid_argument("Invalid binary tree: node count exceeds data size");
+        }
+        linearized.reserve(nodeCount * 2);
+
+        // remaining children to read for each open node
+        std::stack<std::uint64_t> remaining;
+        RecordHeaderReader headers(chains);
+        for (std::uint64_t i = 0; i < nodeCount; ++i) {
+            if (i > 0 && remaining.empty()) {
+                throw std::invalid_argument("Invalid binary tree: nodes found after the root's subtree ended");
+            }
+            std::uint64_t childCount = headers.next(cursor, end);
+            T value;
+            decodeBinaryValue(cursor, end, value);
+
+            if (!remaining.empty()) {
+                --remaining.top();
+            }
+            linearized.push_back(std::move(value));
+            remaining.push(childCount);
+            // close every node whose children have all been read
+            while (!remaining.empty() && remaining.top() == 0) {
+                remaining.pop();
+                linearized.push_back(std::nullopt);
+            }
+        }
+        if (!remaining.empty()) {
+            throw std::invalid_argument("Invalid binary tree: fewer nodes than child counts require");
+        }
+    }
+
+    /**
+     * @brief Encodes the tree in the compressed container format; see BlockCompression.h.
+     * 
+     * Values are encoded as by `serializeBinary` and gathered in pre-order into
+     * blocks of about `blockSize` bytes, each compressed on its own. Child counts
+     * and payload sizes go to a separate structure block, so readers can find any
+     * node's value without decompressing the blocks before it.
+     * 
+     * @param out Buffer to append to.
+     * @param blockSize Uncompressed bytes of values after which a new block is started.
+     */
+    void writeCompressed(std::string& out, size_t blockSize) const {
+        std::string structure, values, blocks, table;
+        structure.reserve(liveNodeCount * 2);
+        std::uint64_t nodeIndex = 0, blockCount = 0;
+        CompressedBlock block{0, 0, 0, 0, 0};
+        auto flushBlock = [&]() {
+            block.rawSize = values.size();
+            block.checksum = fnv1a64(values);
+            size_t start = blocks.size();
+            compressBlock(blocks, values);
+            block.compressedSize = blocks.size() - start;
+            writeCompressedBlockHeader(table, block, true);
+            ++blockCount;
+            values.clear();
+        };
+
+        std::stack<const Node<T>*> stack;
+        if (root) {
+            stack.push(root.get());
+        }
+        auto writePayload = [&](const Node<T>* node) {
+            // blocks only break between nodes, so each value is decompressed from a single block
+            if (!values.empty() && values.size() >= blockSize) {
+                flushBlock();
+                block.firstNode = nodeIndex;
+            }
+            size_t start = values.size();
+            encodeBinaryValue(values, node->value);
+            writeVarint(structure, values.size() - start);
+            ++nodeIndex;
+        };
+        while (!stack.empty()) {
+            const Node<T>* current = stack.top();
+            stack.pop();
+
+            // chain records as in the binary format, with a payload size in place of each payload
+            if (std::uint64_t length = chainLength(current)) {
+                writeChainHeader(structure, length);
+                for (; length > 0; --length) {
+                    writePayload(current);
+                    current = current->children.front().get();
+                }
+            }
+            writeRecordHeader(structure, current->children.size());
+            writePayload(current);
+            for (auto itr = current->children.rbegin(); itr != current->children.rend(); ++itr) {
+                stack.push(itr->get());
+            }
+        }
+        if (nodeIndex > 0) {
+            flushBlock();
+        }
+
+        out.append(COMPRESSED_TREE_MAGIC, COMPRESSED_TREE_MAGIC_SIZE);
+        out.push_back(static_cast<char>(COMPRESSED_TREE_VERSION));
+        out.push_back(0);
+        writeVarint(out, nodeIndex);
+        writeVarint(out, blockCount);
+        std::string packed;
+        compressBlock(packed, structure);
+        writeCompressedBlockHeader(out, CompressedBlock{0, structure.size(), packed.size(), fnv1a64(structure), 0}, false);
+        out += packed;
+        out += table;
+        out += blocks;
+    }
+
+    /**
+     * @brief Decodes a compressed container, throwing on the first error.
+     * 
+     * Blocks are decompressed one at a time into a reused buffer, so types whose
+     * values view their input (such as StoryNodeView) cannot be read this way.
+     * 
+     * @param serialized Compressed tree data.
+     * @param linearized Receives the linearized tree data; holds everything decoded before an error.
+     * @throw std::invalid_argument If the data is malformed, truncated or fails a checksum.
+     */
+    static void parseCompressed(std::string_view serialized, std::vector<std::optional<T>>& linearized) {
+        TREE_METRICS_TIME(parseLatency);
+        TREE_METRICS_ADD(bytesParsed, serialized.size());
+        CompressedTreeLayout layout = readCompressedLayout(serialized);
+        const char* cursor = layout.structure.data();
+        const char* end = cursor + layout.structure.size();
+        linearized.reserve(layout.nodeCount * 2);
+
+        std::string block;
+        size_t nextBlock = 0;
+        const char* value = nullptr;
+        const char* valuesEnd = nullptr;
+        // remaining children to read for each open node
+        std::vector<std::uint64_t> remaining;
+        RecordHeaderReader headers(layout.chains);
+        for (std::uint64_t i = 0; i < layout.nodeCount; ++i) {
+            if (i > 0 && remaining.empty()) {
+                throw std::invalid_argument("Invalid compressed tree: nodes found after the root's subtree ended");
+            }
+            if (nextBlock < layout.blocks.size() && layout.blocks[nextBlock].firstNode == i) {
+                if (value != valuesEnd) {
+                    throw std::invalid_argument("Invalid compressed tree: block holds more values than its nodes");
+                }
+                readCompressedBlock(serialized, layout.blocks[nextBlock++], block);
+                value = block.data();
+                valuesEnd = value + block.size();
+            }
+            std::uint64_t childCount = headers.next(cursor, end);
+            std::uint64_t payloadSize = readVarint(cursor, end);
+            if (payloadSize > static_cast<std::uint64_t>(valuesEnd - value)) {
+                throw std::invalid_argument("Invalid compressed tree: value runs past the end of its block");
+            }
+            const char* payloadEnd = value + payloadSize;
+            T decoded;
+            decodeBinaryValue(value, payloadEnd, decoded);
+            if (value != payloadEnd) {
+                throw std::invalid_argument("Invalid compressed tree: value size does not match its payload");
+            }
+
+            if (!remaining.empty()) {
+                --remaining.back();
+            }
+            linearized.push_back(std::move(decoded));
+            remaining.push_back(childCount);
+            while (!remaining.empty() && remaining.back() == 0) {
+                remaining.pop_back();
+                linearized.push_back(std::nullopt);
+            }
+        }
+        if (!remaining.empty()) {
+            throw std::invalid_argument("Invalid compressed tree: fewer nodes than child counts require");
+        }
+        if (value != valuesEnd || nextBlock != layout.blocks.size()) {
+            throw std::invalid_argument("Invalid compressed tree: blocks hold more values than there are nodes");
+        }
+    }
+
+    /**
+     * @brief Parses an in-memory text serialization into its linearized representation.
+     * 
+     * Buffer counterpart of the stream overload, with the same validation and
+     * error reporting.
+     * 
+     * @param serialized Serialized tree text.
+     * @return std::vector<std::optional<T>> The linearized tree data.
+     */
+    static std::vector<std::optional<T>> parseLinearized(std::string_view serialized) {
+        std::vector<std::optional<T>> linearized;
+        try {
+            parseText(serialized, linearized);
+        } catch (std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+        }
+        return linearized;
+    }
+
+    /**
+     * @brief Parses the text serialization into its linearized representation.
+     * 
+     * Validates line formatting and node to end-of-children token ratios. Errors
+     * are reported to std::cerr, and the values parsed up to that point are returned.
+     * Shared by `deserialize` and other tree layouts that read the same format.
+     * 
+     * @param is Stream holding the serialized tree.
+     * @return std::vector<std::optional<T>> The linearized tree data.
+     */
+    static std::vector<std::optional<T>> parseLinearized(std::istream& is) {
+        std::vector<std::optional<T>> linearized;
+        std::string line;
+        int nodeCount = 0, eocTokenCount = 0, lineNumber = 0;
+        std::stringstream errMsg;
+        TREE_METRICS_TIME(parseLatency);
+
+        try {
+
+        while (std::getline(is, line)) {
+            ++lineNumber;
+            TREE_METRICS_ADD(linesParsed, 1);
+            TREE_METRICS_ADD(bytesParsed, line.size() + 1);
+            LineRecord record = LineScanner::classify(line);
+            // Handle end-of-children tokens
+            if (record.kind == LineRecord::EndOfChildren) {
+                // Invalid hierarchical structure - too many end-of-children tokens
+                if (record.count > static_cast<size_t>(nodeCount - eocTokenCount)) {
+                    errMsg << "Invalid tree serialization: too many end-of-children tokens\n"
+                        << "A valid serialization should have one end-of-children token for every node.\n"
+                        << "Occurred during line " << lineNumber << " of the serialization.\n";
+                    throw std::invalid_argument(errMsg.str());
+                }
+                linearized.insert(linearized.end(), record.count, std::nullopt);
+                eocTokenCount += static_cast<int>(record.count);
+            // Handle node values
+            } else if (record.kind == LineRecord::NodeValue) {
+                T value;
+                if (parseValue(record.value(), value)) {
+                    linearized.push_back(std::move(value));
+                    nodeCount++;
+                } else {
+                    errMsg << "Invalid tree serialization: unable to parse value\n"
+                        << "Unable to parse value from line while deserializing tree: " << line << "\n"
+                        << "Occurred during line " << lineNumber << " of the serialization.\n";
+                    throw std::invalid_argument(errMsg.str());
+                }
+            // Invalid line format
+            } else {
+                errMsg << "Invalid tree serialization: invalid line format\n"
+                    << "Malformed line detected while deserializing tree: " << line << "\n"
+                    << "Expected format: '[n]: value' for nodes or '[X]' / '[X*n]' for end-of-children tokens.\n"
+                    << "Occurred during line " << lineNumber << " of the serialization.\n";
+                throw std::invalid_argument(errMsg.str());
+            }
+        }
+
+        // Invalid hierarchical structure - too few end-of-children tokens
+        if (nodeCount != eocTokenCount) {
+            errMsg << "Invalid tree serialization: Too few end-of-children tokens\n"
+                << "A valid serialization should have one end-of-children token for every node.\n";
+            throw std::invalid_argument(errMsg.str());
+        }
+    } catch (std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+    }
+
+        return linearized;
+    }
+
+public:
+    /**
+     * @brief A node's ID together with read-only access to its value.
+     */
+    struct NodeRef {
+        int id;
+        const T& value;
+    };
+
+    /**
+     * @brief Lightweight, non-owning view of a node's children, returned by `children`.
+     */
+    class ChildRange {
+    public:
+        using Storage = const std::unique_ptr<Node<T>>*;
+
+        class iterator {
+        public:
+            using iterator_category = std::random_access_iterator_tag;
+            using value_type = NodeRef;
+            using difference_type = std::ptrdiff_t;
+            using pointer = void;
+            using reference = NodeRef;
+
+            iterator() = default;
+            explicit iterator(Storage position) noexcept : position(position) {}
+
+            NodeRef operator*() const noexcept { return NodeRef{(*position)->ID, (*position)->value}; }
+            NodeRef operator[](difference_type offset) const noexcept { return *(*this + offset); }
+            iterator& operator++() noexcept { ++position; return *this; }
+            iterator operator++(int) noexcept { iterator copy = *this; ++position; return copy; }
+            iterator& operator--() noexcept { --position; return *this; }
+            iterator operator--(int) noexcept { iterator copy = *this; --position; return copy; }
+            iterator& operator+=(difference_type offset) noexcept { position += offset; return *this; }
+            iterator& operator-=(difference_type offset) noexcept { position -= offset; return *this; }
+            iterator operator+(difference_type offset) const noexcept { return iterator(position + offset); }
+            iterator operator-(difference_type offset) const noexcept { return iterator(position - offset); }
+            difference_type operator-(const iterator& other) const noexcept { return position - other.position; }
+            bool operator==(const iterator& other) const noexcept { return position == other.position; }
+            bool operator!=(const iterator& other) const noexcept { return position != other.position; }
+            bool operator<(const iterator& other) const noexcept { return position < other.position; }
+
+        private:
+            Storage position = nullptr;
+        };
+
+        ChildRange(Storage first, Storage last) noexcept : first(first), last(last) {}
+
+        iterator begin() const noexcept { return iterator(first); }
+        iterator end() const noexcept { return iterator(last); }
+        size_t size() const noexcept { return static_cast<size_t>(last - first); }
+        bool empty() const noexcept { return first == last; }
+        NodeRef operator[](size_t index) const noexcept { return NodeRef{first[index]->ID, first[index]->value}; }
+
+    private:
+        Storage first;
+        Storage last;
+    };
+
+    /**
+     * @brief Pre-order iterator over a subtree: each node before its children, children left-to-right.
+     * 
+     * Holds a stack of the nodes still to visit; values are never copied.
+     */
+    class PreOrderIterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = NodeRef;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = NodeRef;
+
+        PreOrderIterator() = default;
+        explicit PreOrderIterator(const Node<T>* start) {
+            if (start) {
+                pending.push_back(start);
+            }
+        }
+
+        NodeRef operator*() const noexcept { return NodeRef{pending.back()->ID, pending.back()->value}; }
+        PreOrderIterator& operator++() {
+            const Node<T>* current = pending.back();
+            pending.pop_back();
+            for (auto itr = current->children.rbegin(); itr != current->children.rend(); ++itr) {
+                pending.push_back(itr->get());
+            }
+            return *this;
+        }
+        PreOrderIterator operator++(int) { PreOrderIterator copy = *this; ++*this; return copy; }
+        bool operator==(const PreOrderIterator& other) const noexcept { return current() == other.current(); }
+        bool operator!=(const PreOrderIterator& other) const noexcept { return current() != other.current(); }
+
+    private:
+        std::vector<const Node<T>*> pending;
+
+        const Node<T>* current() const noexcept { return pending.empty() ? nullptr : pending.back(); }
+    };
+
+    /**
+     * @brief Post-order iterator over a subtree: each node after all of its children.
+     * 
+     * Holds the path from the subtree's root to the current node, with the next
+     * child to descend into at each level.
+     */
+    class PostOrderIterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = NodeRef;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = NodeRef;
+
+        PostOrderIterator() = default;
+        explicit PostOrderIterator(const Node<T>* start) {
+            if (start) {
+                path.push_back({start, 0});
+                descend();
+            }
+        }
+
+        NodeRef operator*() const noexcept { return NodeRef{path.back().first->ID, path.back().first->value}; }
+        PostOrderIterator& operator++() {
+            path.pop_back();
+            descend();
+            return *this;
+        }
+        PostOrderIterator operator++(int) { PostOrderIterator copy = *this; ++*this; return copy; }
+        bool operator==(const PostOrderIterator& other) const noexcept { return current() == other.current(); }
+        bool operator!=(const PostOrderIterator& other) const noexcept { return current() != other.current(); }
+
+    private:
+        std::vector<std::pair<const Node<T>*, size_t>> path; // (node, index of the next child to visit)
+
+        // moves down to the leftmost unvisited leaf below the top of the path
+        void descend() {
+            while (!path.empty() && path.back().second < path.back().first->children.size()) {
+                const Node<T>* child = path.back().first->children[path.back().second++].get();
+                path.push_back({child, 0});
+            }
+        }
+        const Node<T>* current() const noexcept { return path.empty() ? nullptr : path.back().first; }
+    };
+
+    /**
+     * @brief Level-order (breadth-first) iterator over a subtree: by depth, then left-to-right.
+     * 
+     * Holds a queue of the nodes still to visit.
+     */
+    class LevelOrderIterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = NodeRef;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = NodeRef;
+
+        LevelOrderIterator() = default;
+        explicit LevelOrderIterator(const Node<T>* start) {
+            if (start) {
+                pending.push_back(start);
+            }
+        }
+
+        NodeRef operator*() const noexcept { return NodeRef{pending.front()->ID, pending.front()->value}; }
+        LevelOrderIterator& operator++() {
+            const Node<T>* current = pending.front();
+            pending.pop_front();
+            for (const auto& child : current->children) {
+                pending.push_back(child.get());
+            }
+            return *this;
+        }
+        LevelOrderIterator operator++(int) { LevelOrderIterator copy = *this; ++*this; return copy; }
+        bool operator==(const LevelOrderIterator& other) const noexcept { return current() == other.current(); }
+        bool operator!=(const LevelOrderIterator& other) const noexcept { return current() != other.current(); }
+
+    private:
+        std::deque<const Node<T>*> pending;
+
+        const Node<T>* current() const noexcept { return pending.empty() ? nullptr : pending.front(); }
+    };
+
+    /**
+     * @brief A traversal of one subtree, usable in range-based for loops.
+     * 
+     * @tparam Iterator One of PreOrderIterator, PostOrderIterator or LevelOrderIterator.
+     */
+    template <typename Iterator>
+    class TraversalRange {
+    public:
+        explicit TraversalRange(const Node<T>* start) noexcept : start(start) {}
+
+        Iterator begin() const { return Iterator(start); }
+        Iterator end() const noexcept { return Iterator(); }
+        bool empty() const noexcept { return start == nullptr; }
+
+    private:
+        const Node<T>* start;
+    };
+
+    /**
+     * @brief Initializes an empty Tree.
+     * 
+     * Constructs a Tree with no root, requiring `setRoot`
+     * to add the root node. This constructor is ideal 
+     * for rebuilding a tree via `delinearize`.
+     */
+    Tree() {
+        T_compatible_check();
+        root = nullptr;
+    };
+
+    /**
+     * @brief Constructs a Tree with a root node from an lvalue.
+     * 
+     * Creates a tree with a root node, copying the provided value.
+     * Suitable for when retaining the original value is necessary.
+     * 
+     * @param value The value for the root node.
+     */
+    Tree(const T& value) {
+        T_compatible_check();
+        setRoot(value);
+    }
+
+    /**
+     * @brief Constructs a Tree with a root node from an rvalue.
+     * 
+     * Efficiently sets the root node using the provided movable
+     * value. Ideal for transferring ownership without copying.
+     * 
+     * @param value The value to move as the root node.
+     */
+    Tree(T&& value) {
+        T_compatible_check();
+        setRoot(std::move(value));
+    }
+    
+    /**
+     * @brief Builds a tree from its linearized representation in bulk.
+     * 
+     * Rebuilds a tree from a linear sequence of optional values, using the
+     * end-of-children tokens (std::nullopt) to know when to move back up a level.
+     * Unlike appending nodes one at a time, this sizes everything up front and
+     * moves the values out of the input instead of copying them. IDs are
+     * assigned in pre-order, the same order `appendNode` would give them.
+     * 
+     * Algorithm:
+     * 1. Count the nodes and each node's children using a stack of open nodes.
+     * 2. Reserve the nodeMap, and each node's children list, to their final sizes.
+     * 3. Walk the data again with a stack of parent nodes:
+     *    - On a value, create the node under the current parent (or as the root),
+     *      assign the next ID, and make it the current parent.
+     *    - On an end-of-children token, pop the current parent.
+     * 
+     * @param linearized Linearized tree data; its values are moved from.
+     * @return Tree<T> The reconstructed tree.
+     * @throw std::invalid_argument If values follow the end of the root's subtree.
+     */
+    static Tree<T> fromLinearized(std::vector<std::optional<T>>&& linearized) {
+        TREE_METRICS_TIME(delinearizeLatency);
+        // First pass: count nodes and children per node, indexed by pre-order position
+        std::vector<size_t> childCounts;
+        std::vector<size_t> open;
+        for (const auto& optValue : linearized) {
+            if (optValue.has_value()) {
+                if (!childCounts.empty() && open.empty()) {
+                    throw std::invalid_argument("Invalid tree serialization: nodes found after the root's subtree ended");
+                }
+                if (!open.empty()) {
+                    childCounts[open.back()]++;
+                }
+                open.push_back(childCounts.size());
+                childCounts.push_back(0);
+            } else if (!open.empty()) {
+                open.pop_back();
+            }
+        }
+
+        // Second pass: build the nodes with all storage reserved
+        Tree<T> tree;
+        tree.nodeMap.reserve(childCounts.size());
+        std::vector<Node<T>*> parents;
+        parents.reserve(open.capacity());
+        for (auto& optValue : linearized) {
+            // Handle node value
+            if (optValue.has_value()) {
+                Node<T>* parent = parents.empty() ? nullptr : parents.back();
+                // instantiate before passing to unique_ptr because make_unique doesn't have access to node constructor
+                Node<T>* node = new Node<T>(std::move(*optValue), parent);
+                if (parent) {
+                    parent->children.push_back(std::unique_ptr<Node<T>>(node));
+                } else {
+                    tree.root.reset(node);
+                }
+                node->children.reserve(childCounts[tree.nextID]);
+                node->ID = tree.nextID++;
+                tree.nodeMap.push_back(node);
+                tree.liveNodeCount++;
+                TREE_METRICS_ADD(nodesBuilt, 1);
+                parents.push_back(node);
+            // Handle end-of-children token
+            } else if (!parents.empty()) {
+                parents.pop_back();
+            }
+        }
+        return tree;
+    }
+
+    /**
+     * @brief Sets the tree's root node.
+     * 
+     * Initializes the tree with a specified value for the root.
+     * Intended for use with an empty tree to start building its
+     * structure. The method assigns a unique ID to the root and 
+     * updates the nodeMap.
+     * 
+     * @param value The value for the root node.
+     * @return int The ID of the root node.
+     * @throw std::logic_error If attempting to set the root on a non-empty tree, or while a batch is being built.
+     */
+    int setRoot(T value) {
+        checkNotBatching();
+        if (root) {
+            throw std::logic_error("The root node has already been set");
+        }
+        // instantiate before passing to unique_ptr because make_unique doesn't have access to node constructor
+        Node<T>* rootNode = new Node<T>(std::move(value));
+        root.reset(rootNode);
+        assignIDs(root.get());
+        annotateLeaf(root.get());
+        recordEdit('=', root.get(), &root->value);
+        return root->ID;
+    }
+
+    /**
+     * @brief Adds a child node under a specified parent.
+     * 
+     * Appends a new node with the provided value as a child to the 
+     * given parent node, updating the nodeMap with a unique ID for
+     * the new node. Returns the ID of the new node for reference.
+     * 
+     * @param parentID ID of the parent node.
+     * @param value Value for the new node.
+     * @return int ID of the new node.
+     * @throw std::invalid_argument If the parent node ID is invalid.
+     * @throw std::logic_error If called while a batch is being built.
+     */
+    int appendNode(int parentID, T value) {
+        checkNotBatching();
+        Node<T>* parentNode = findNode(parentID);
+        if (!parentNode) {
+            std::stringstream errMsg;
+            errMsg << "Parent node with ID " << parentID << " does not exist.";
+            throw std::invalid_argument(errMsg.str());
+        }
+
+        // instantiate before passing to unique_ptr because make_unique doesn't have acccess to node constructor
         parentNode->children.push_back(std::unique_ptr<Node<T>>(new Node<T>(std::move(value), parentNode)));
         assignIDs(parentNode->children.back().get());
+        annotateLeaf(parentNode->children.back().get());
+        recordEdit('+', parentNode, &parentNode->children.back()->value);
 
         return parentNode->children.back()->ID;
     }
@@ -434,31 +1663,35 @@ public:
      * 
      * @param nodeID ID of the node to remove.
      * @throw std::invalid_argument If the node is the root or the ID is invalid.
+     * @throw std::logic_error If called while a batch is being built.
      */
     void removeNode(int nodeID) {
+        checkNotBatching();
         if (nodeID == getRootID()) {
             throw std::invalid_argument("The root node cannot be removed");
         }
 
         // find the node in the nodeMap
-        auto nodeItr = nodeMap.find(nodeID);
-        if (nodeItr == nodeMap.end()) {
+        Node<T>* nodeToRemove = findNode(nodeID);
+        if (!nodeToRemove) {
             std::stringstream errMsg;
             errMsg << "Node with ID " << nodeID << " does not exist";
             throw std::invalid_argument(errMsg.str());
         }
-
-        // lambda to recursively erase node, and its subtree's, nodeMap entries
-        std::function<void(Node<T>*)> cleanupSubtree = [&](Node<T>* node) {
-            for (auto& child : node->children) {
-                cleanupSubtree(child.get());
-            }
-            nodeMap.erase(node->ID);
-        };
+        recordEdit('-', nodeToRemove, nullptr);
 
         // Remove the node and its subtree from the nodeMap
-        Node<T>* nodeToRemove = nodeItr->second;
-        cleanupSubtree(nodeToRemove);
+        walkStack.clear();
+        walkStack.push_back(nodeToRemove);
+        while (!walkStack.empty()) {
+            Node<T>* current = walkStack.back();
+            walkStack.pop_back();
+            nodeMap[current->ID] = nullptr;
+            liveNodeCount--;
+            for (auto& child : current->children) {
+                walkStack.push_back(child.get());
+            }
+        }
 
         // remove the node from its parent's list of children
         if (nodeToRemove->parent) {
@@ -467,8 +1700,610 @@ public:
                         [nodeToRemove](const std::unique_ptr<Node<T>>& child) {
                             return child.get() == nodeToRemove;
                         }), siblings.end());
+            if (annotating) {
+                refreshAncestors(nodeToRemove->parent);
+            }
+        }
+        // the entire subtree is now released by unique_ptrs, iteratively (see ~Node)
+    }
+
+    /**
+     * @brief Moves a node and its subtree to become the last child of another node.
+     * 
+     * Ownership of the subtree is handed over and its parent pointer updated; no
+     * values are copied and every node keeps its ID. Costs the size of the two
+     * sibling lists plus the depth of the new parent, and a walk of the subtree
+     * only while path statistics are enabled, since their depths change.
+     * 
+     * @param nodeID ID of the node to move.
+     * @param newParentID ID of the node to move it under.
+     * @throw std::invalid_argument If either ID is invalid, the node is the root,
+     *                              or the new parent is inside the moved subtree.
+     * @throw std::logic_error If called while a batch is being built.
+     */
+    void moveSubtree(int nodeID, int newParentID) {
+        checkNotBatching();
+        if (nodeID == getRootID()) {
+            throw std::invalid_argument("The root node cannot be moved");
+        }
+        Node<T>* node = checkedNode(nodeID);
+        Node<T>* newParent = findNode(newParentID);
+        if (!newParent) {
+            std::stringstream errMsg;
+            errMsg << "Parent node with ID " << newParentID << " does not exist.";
+            throw std::invalid_argument(errMsg.str());
+        }
+        for (const Node<T>* ancestor = newParent; ancestor; ancestor = ancestor->parent) {
+            if (ancestor == node) {
+                throw std::invalid_argument("A node cannot be moved into its own subtree");
+            }
+        }
+        // both positions are journaled as they are before the move, which is how replay resolves them
+        if (journaling) {
+            journal += ">[";
+            writePath(journal, node);
+            journal += "]: ";
+            writePath(journal, newParent);
+            journal.push_back('\n');
+        }
+
+        Node<T>* oldParent = node->parent;
+        newParent->children.push_back(unlinkChild(node));
+        node->parent = newParent;
+
+        if (annotating) {
+            annotateSubtree(node);
+            refreshAncestors(oldParent);
+            refreshAncestors(newParent);
+        }
+    }
+
+    /**
+     * @brief Cuts a node and its subtree out of the tree, returning them as a tree of their own.
+     * 
+     * Ownership of the nodes passes to the returned tree without copying any
+     * values. The nodes' IDs are released here exactly as by `removeNode`, and
+     * the returned tree numbers them afresh in pre-order, its root being 0.
+     * Any storage retained by this tree is shared with the returned one.
+     * 
+     * @param nodeID ID of the subtree's root.
+     * @return Tree<T> The detached subtree.
+     * @throw std::invalid_argument If the node is the root or the ID is invalid.
+     * @throw std::logic_error If called while a batch is being built.
+     */
+    Tree<T> detachSubtree(int nodeID) {
+        checkNotBatching();
+        if (nodeID == getRootID()) {
+            throw std::invalid_argument("The root node cannot be detached");
+        }
+        Node<T>* node = checkedNode(nodeID);
+        recordEdit('-', node, nullptr);
+
+        Node<T>* oldParent = node->parent;
+        Tree<T> detached;
+        detached.root = unlinkChild(node);
+        detached.root->parent = nullptr;
+        detached.storage = storage;
+
+        // release the IDs here while numbering the nodes in the new tree, in one pre-order walk
+        walkStack.clear();
+        walkStack.push_back(node);
+        while (!walkStack.empty()) {
+            Node<T>* current = walkStack.back();
+            walkStack.pop_back();
+            nodeMap[current->ID] = nullptr;
+            liveNodeCount--;
+            current->ID = detached.nextID++;
+            detached.nodeMap.push_back(current);
+            detached.liveNodeCount++;
+            for (auto itr = current->children.rbegin(); itr != current->children.rend(); ++itr) {
+                walkStack.push_back(itr->get());
+            }
+        }
+
+        if (annotating) {
+            refreshAncestors(oldParent);
+        }
+        return detached;
+    }
+
+    /**
+     * @brief Moves every node of another tree in under a node of this one.
+     * 
+     * The other tree's root becomes the last child of `parentID`. Ownership of
+     * the nodes is handed over without copying any values; they are given new
+     * IDs here, in pre-order, as `appendNode` would give them. The other tree is
+     * left empty, and any storage it retained is kept alive by this tree.
+     * While tracking changes, one journal line per grafted node is recorded.
+     * 
+     * @param parentID ID of the node to graft under.
+     * @param subtree Tree to take the nodes from.
+     * @return int ID of the grafted root in this tree.
+     * @throw std::invalid_argument If the parent ID is invalid, or `subtree` is empty or this tree.
+     * @throw std::logic_error If called while a batch is being built.
+     */
+    int graftSubtree(int parentID, Tree<T>&& subtree) {
+        checkNotBatching();
+        Node<T>* parentNode = findNode(parentID);
+        if (!parentNode) {
+            std::stringstream errMsg;
+            errMsg << "Parent node with ID " << parentID << " does not exist.";
+            throw std::invalid_argument(errMsg.str());
+        }
+        if (&subtree == this) {
+            throw std::invalid_argument("A tree cannot be grafted into itself");
+        }
+        if (!subtree.root) {
+            throw std::invalid_argument("Cannot graft an empty tree");
+        }
+
+        if (subtree.storage && subtree.storage != storage) {
+            storage = storage ? std::make_shared<const std::pair<std::shared_ptr<const void>, std::shared_ptr<const void>>>(
+                                    std::move(storage), std::move(subtree.storage))
+                              : std::move(subtree.storage);
+        }
+        Node<T>* grafted = subtree.root.get();
+        grafted->parent = parentNode;
+        parentNode->children.push_back(std::move(subtree.root));
+        subtree = Tree<T>();
+
+        int firstID = nextID;
+        assignIDs(grafted);
+        if (annotating) {
+            annotateSubtree(grafted);
+            refreshAncestors(parentNode);
+        }
+        // in pre-order every node's earlier siblings are already journaled, so replay appends each in place
+        if (journaling) {
+            for (size_t id = static_cast<size_t>(firstID); id < nodeMap.size(); ++id) {
+                recordEdit('+', nodeMap[id]->parent, &nodeMap[id]->value);
+            }
+        }
+        return grafted->ID;
+    }
+
+    /**
+     * @brief Appends and removals collected by `batch`, applied together when the batch commits.
+     * 
+     * IDs handed out by `append` are the IDs the nodes will have once committed,
+     * exactly as if each append had been an `appendNode` call, so later calls in
+     * the same batch may append under them or remove them.
+     */
+    class Batch {
+    public:
+        /**
+         * @brief Queues a new node as the last child of an existing or queued node.
+         * 
+         * @param parentID ID of a live node, or an ID returned by this batch.
+         * @param value Value for the new node.
+         * @return int ID the new node will have.
+         * @throw std::invalid_argument If the parent node ID is invalid.
+         */
+        int append(int parentID, T value) {
+            if (!tree.findNode(parentID) && !isQueued(parentID)) {
+                std::stringstream errMsg;
+                errMsg << "Parent node with ID " << parentID << " does not exist.";
+                throw std::invalid_argument(errMsg.str());
+            }
+            appends.push_back(PendingAppend{parentID, std::move(value)});
+            return firstID + static_cast<int>(appends.size()) - 1;
+        }
+
+        /**
+         * @brief Queues the removal of a node and its subtree.
+         * 
+         * Removals take effect after every append in the batch, so nodes
+         * appended under a removed node are removed with it.
+         * 
+         * @param nodeID ID of a live node, or an ID returned by this batch.
+         * @throw std::invalid_argument If the node is the root or the ID is invalid.
+         */
+        void remove(int nodeID) {
+            if (nodeID == tree.getRootID()) {
+                throw std::invalid_argument("The root node cannot be removed");
+            }
+            if (!tree.findNode(nodeID) && !isQueued(nodeID)) {
+                std::stringstream errMsg;
+                errMsg << "Node with ID " << nodeID << " does not exist";
+                throw std::invalid_argument(errMsg.str());
+            }
+            removals.push_back(nodeID);
+        }
+
+        /**
+         * @brief Reserves room for a known number of appends.
+         * 
+         * @param appendCount Number of appends expected in this batch.
+         */
+        void reserve(size_t appendCount) {
+            appends.reserve(appendCount);
+        }
+
+    private:
+        friend class Tree<T>;
+
+        struct PendingAppend {
+            int parentID;
+            T value;
+        };
+
+        explicit Batch(Tree<T>& tree) noexcept : tree(tree), firstID(tree.nextID) {}
+
+        bool isQueued(int nodeID) const noexcept {
+            return nodeID >= firstID && nodeID < firstID + static_cast<int>(appends.size());
+        }
+
+        /**
+         * @brief Applies the queued appends, then the queued removals.
+         * 
+         * @throw std::logic_error If the tree's IDs moved on since the batch started, e.g. it was reassigned.
+         */
+        void commit() {
+            if (tree.nextID != firstID) {
+                throw std::logic_error("The tree changed while a batch was being built");
+            }
+            if (tree.journaling) {
+                // the journal needs each edit's position at the time it happens, so replay them one by one
+                for (auto& append : appends) {
+                    tree.appendNode(append.parentID, std::move(append.value));
+                }
+                for (int nodeID : removals) {
+                    if (tree.findNode(nodeID)) {
+                        tree.removeNode(nodeID);
+                    }
+                }
+                return;
+            }
+
+            // grow every parent's children vector once, to its final size
+            std::vector<size_t> queuedChildren(appends.size(), 0);
+            std::vector<int> existingParents;
+            for (const auto& append : appends) {
+                if (isQueued(append.parentID)) {
+                    queuedChildren[append.parentID - firstID]++;
+                } else {
+                    existingParents.push_back(append.parentID);
+                }
+            }
+            std::sort(existingParents.begin(), existingParents.end());
+            for (auto itr = existingParents.begin(); itr != existingParents.end();) {
+                auto runEnd = std::upper_bound(itr, existingParents.end(), *itr);
+                auto& children = tree.nodeMap[*itr]->children;
+                children.reserve(children.size() + static_cast<size_t>(runEnd - itr));
+                itr = runEnd;
+            }
+            tree.nodeMap.reserve(tree.nodeMap.size() + appends.size());
+
+            for (size_t i = 0; i < appends.size(); ++i) {
+                // parents are always appended before their children, so every parent exists by now
+                Node<T>* parent = tree.nodeMap[appends[i].parentID];
+                // instantiate before passing to unique_ptr because make_unique doesn't have access to node constructor
+                Node<T>* node = new Node<T>(std::move(appends[i].value), parent);
+                parent->children.push_back(std::unique_ptr<Node<T>>(node));
+                node->children.reserve(queuedChildren[i]);
+                node->ID = tree.nextID++;
+                tree.nodeMap.push_back(node);
+                tree.liveNodeCount++;
+            }
+
+            // release the removed subtrees' IDs, noting each parent that loses a child
+            std::vector<Node<T>*> parents;
+            for (int nodeID : removals) {
+                Node<T>* removed = tree.findNode(nodeID);
+                if (!removed) {
+                    continue; // already inside a removed subtree
+                }
+                parents.push_back(removed->parent);
+                tree.walkStack.clear();
+                tree.walkStack.push_back(removed);
+                while (!tree.walkStack.empty()) {
+                    Node<T>* current = tree.walkStack.back();
+                    tree.walkStack.pop_back();
+                    tree.nodeMap[current->ID] = nullptr;
+                    tree.liveNodeCount--;
+                    for (auto& child : current->children) {
+                        tree.walkStack.push_back(child.get());
+                    }
+                }
+            }
+            // one pass per surviving parent unlinks all of its removed children; parents inside
+            // removed subtrees are dropped first, since unlinking frees them
+            std::sort(parents.begin(), parents.end());
+            parents.erase(std::unique(parents.begin(), parents.end()), parents.end());
+            parents.erase(std::remove_if(parents.begin(), parents.end(),
+                        [this](const Node<T>* parent) { return tree.nodeMap[parent->ID] != parent; }), parents.end());
+            for (Node<T>* parent : parents) {
+                auto& siblings = parent->children;
+                siblings.erase(std::remove_if(siblings.begin(), siblings.end(),
+                            [this](const std::unique_ptr<Node<T>>& child) {
+                                return tree.nodeMap[child->ID] == nullptr;
+                            }), siblings.end());
+            }
+
+            if (tree.annotating) {
+                annotate(parents);
+            }
+        }
+
+        /**
+         * @brief Updates path statistics for the committed nodes and the parents they changed.
+         * 
+         * Appended nodes only have appended descendants and come after their parents
+         * in ID order, so depths are set in ID order and summaries built in reverse,
+         * after which each pre-existing parent's ancestors are refreshed as by
+         * single edits. The cost follows the batch, not the tree.
+         * 
+         * @param parents Surviving parents that lost children to removals.
+         */
+        void annotate(std::vector<Node<T>*>& parents) {
+            tree.pathAnnotations.resize(tree.nodeMap.size());
+            for (int id = firstID; id < tree.nextID; ++id) {
+                if (const Node<T>* node = tree.nodeMap[id]) {
+                    tree.pathAnnotations[id].depth = tree.pathAnnotations[node->parent->ID].depth + 1;
+                }
+            }
+            for (int id = tree.nextID - 1; id >= firstID; --id) {
+                if (const Node<T>* node = tree.nodeMap[id]) {
+                    tree.summarizeChildren(node);
+                }
+            }
+
+            for (const auto& append : appends) {
+                if (!isQueued(append.parentID)) {
+                    parents.push_back(tree.nodeMap[append.parentID]);
+                }
+            }
+            for (const Node<T>* parent : parents) {
+                // parents appended by this batch are up to date, and removed ones are gone
+                if (parent && parent->ID < firstID) {
+                    tree.refreshAncestors(parent);
+                }
+            }
+        }
+
+        Tree<T>& tree;
+        int firstID; // ID of the first queued append
+        std::vector<PendingAppend> appends;
+        std::vector<int> removals;
+    };
+
+    /**
+     * @brief Applies many appends and removals at once.
+     * 
+     * `build` receives a Batch to queue mutations on; nothing changes until it
+     * returns, and if it throws nothing changes at all. On commit every
+     * children vector is grown once to its final size, `nodeMap` is reserved
+     * once, and removals are unlinked with a single pass over each affected
+     * parent's children instead of one pass per removed node. Path statistics,
+     * if enabled, are computed for the new nodes and refreshed above the edited
+     * parents only. While tracking changes, the batch is journaled as the
+     * equivalent appendNode and removeNode calls. The tree itself must not be
+     * edited from inside `build`.
+     * 
+     * @code
+     * tree.batch([&](auto& b) {
+     *     int scene = b.append(tree.getRootID(), value);
+     *     b.append(scene, other);
+     * });
+     * @endcode
+     * 
+     * @param build Callable taking `Batch&`.
+     * @throw std::invalid_argument If a queued mutation refers to an invalid node.
+     * @throw std::logic_error If `build` edits the tree directly or starts another batch.
+     */
+    template <typename F>
+    void batch(F&& build) {
+        checkNotBatching();
+        Batch pending(*this);
+        batching = true;
+        try {
+            build(pending);
+        } catch (...) {
+            batching = false;
+            throw;
+        }
+        batching = false;
+        pending.commit();
+    }
+
+    /**
+     * @brief Starts or stops recording edits in the journal.
+     * 
+     * While enabled, every setRoot, appendNode, removeNode and subtree move appends
+     * one line to the journal (a graft, one per grafted node), so saving the changes costs time proportional to the edits
+     * rather than to the tree (see `saveStorylineIncremental`). Stopping keeps
+     * the edits recorded so far. For the journal to be replayable, tracking must
+     * start while the tree still matches what was last saved.
+     * 
+     * @param enabled Whether to record edits.
+     */
+    void trackChanges(bool enabled) noexcept {
+        journaling = enabled;
+    }
+
+    /**
+     * @brief Checks whether edits are being recorded.
+     * 
+     * @return true if `trackChanges(true)` is in effect.
+     */
+    bool isTrackingChanges() const noexcept {
+        return journaling;
+    }
+
+    /**
+     * @brief Gets the edits recorded since the journal was last cleared.
+     * 
+     * @return std::string const& One line per edit, in the format read by `applyJournal`.
+     */
+    const std::string& pendingChanges() const noexcept {
+        return journal;
+    }
+
+    /**
+     * @brief Discards the recorded edits, typically once they have been saved.
+     */
+    void clearChanges() noexcept {
+        journal.clear();
+    }
+
+    /**
+     * @brief Replays journaled edits against the tree.
+     * 
+     * Each line is one edit, addressing nodes by their position as child indices
+     * from the root ("/" is the root, "/2/0" the first child of its third child):
+     *    "=[/]: value"       set the root
+     *    "+[/2]: value"      append a child to the node at /2
+     *    "-[/2/0]"           remove the node at /2/0 and its subtree
+     *    ">[/2/0]: /1"       move the node at /2/0 to be the last child of the node at /1
+     * Edits applied here are not recorded again.
+     * 
+     * @param edits Journal text, as produced by `pendingChanges`.
+     * @throw std::invalid_argument If a line is malformed or refers to a missing node;
+     *                              the edits before it stay applied.
+     * @throw std::logic_error If called while a batch is being built.
+     */
+    void applyJournal(std::string_view edits) {
+        checkNotBatching();
+        bool wasJournaling = journaling;
+        journaling = false;
+        try {
+            size_t lineStart = 0;
+            while (lineStart < edits.size()) {
+                size_t lineEnd = edits.find('\n', lineStart);
+                if (lineEnd == std::string_view::npos) {
+                    lineEnd = edits.size();
+                }
+                std::string_view line = edits.substr(lineStart, lineEnd - lineStart);
+                lineStart = lineEnd + 1;
+                if (line.empty()) {
+                    continue;
+                }
+
+                size_t pathEnd = line.find(']');
+                char op = line[0];
+                if (line.size() < 4 || line[1] != '[' || pathEnd == std::string_view::npos ||
+                    (op != '=' && op != '+' && op != '-' && op != '>')) {
+                    throw std::invalid_argument("Invalid journal: malformed line: " + std::string(line));
+                }
+                std::string_view path = line.substr(2, pathEnd - 2);
+                if (op == '-') {
+                    if (pathEnd != line.size() - 1) {
+                        throw std::invalid_argument("Invalid journal: malformed line: " + std::string(line));
+                    }
+                    removeNode(resolvePath(path)->ID);
+                    continue;
+                }
+                if (op == '>') {
+                    if (line.compare(pathEnd, 3, "]: ") != 0) {
+                        throw std::invalid_argument("Invalid journal: malformed line: " + std::string(line));
+                    }
+                    // resolve both before moving; the destination is a position in the tree before the move
+                    Node<T>* node = resolvePath(path);
+                    Node<T>* newParent = resolvePath(line.substr(pathEnd + 3));
+                    moveSubtree(node->ID, newParent->ID);
+                    continue;
+                }
+
+                T value;
+                if (line.compare(pathEnd, 3, "]: ") != 0 || !parseValue(line.substr(pathEnd + 3), value)) {
+                    throw std::invalid_argument("Invalid journal: unable to parse value: " + std::string(line));
+                }
+                if (op == '=') {
+                    if (root) {
+                        throw std::invalid_argument("Invalid journal: the root node has already been set");
+                    }
+                    setRoot(std::move(value));
+                } else {
+                    appendNode(resolvePath(path)->ID, std::move(value));
+                }
+            }
+        } catch (...) {
+            journaling = wasJournaling;
+            throw;
+        }
+        journaling = wasJournaling;
+    }
+
+    /**
+     * @brief Starts or stops maintaining per-node path statistics.
+     * 
+     * Enabling computes the statistics for the whole tree in one pass. From then
+     * on edits update them incrementally, refreshing only the ancestors of the
+     * edited node until one is left unchanged (plus the moved or grafted nodes), so
+     * `pathStats` answers in constant time. Disabling releases them.
+     * 
+     * @param enabled Whether to maintain the statistics.
+     */
+    void annotatePaths(bool enabled) {
+        annotating = enabled;
+        pathAnnotations.clear();
+        if (!enabled) {
+            pathAnnotations.shrink_to_fit();
+            return;
+        }
+        if (root) {
+            annotateSubtree(root.get());
+        }
+    }
+
+    /**
+     * @brief Checks whether path statistics are being maintained.
+     * 
+     * @return true if `annotatePaths(true)` is in effect.
+     */
+    bool isAnnotatingPaths() const noexcept {
+        return annotating;
+    }
+
+    /**
+     * @brief Gets a node's depth, ending count and distances to its nearest and farthest endings.
+     * 
+     * @param nodeID ID of the node.
+     * @return PathStats const& The node's statistics, valid until the next edit.
+     * @throw std::logic_error If path statistics are not enabled.
+     * @throw std::invalid_argument If node ID is invalid.
+     */
+    const PathStats& pathStats(int nodeID) const {
+        if (!annotating) {
+            throw std::logic_error("Path statistics are not enabled; call annotatePaths(true) first");
         }
-        // the entire subtree is now implicitly released because of unique_ptrs and vectors
+        return pathAnnotations[checkedNode(nodeID)->ID];
+    }
+
+    /**
+     * @brief Takes an immutable, compacted snapshot of the tree.
+     * 
+     * The snapshot stores node metadata in packed pre-order arrays and the
+     * values in a separate array, which makes navigation and subtree walks far
+     * more cache friendly for trees that are no longer edited. Requires
+     * FrozenTree.h; `FrozenTree::thaw` converts back to a Tree.
+     * 
+     * @return FrozenTree<T> A snapshot holding copies of the values.
+     */
+    FrozenTree<T> freeze() const& {
+        return FrozenTree<T>(*this);
+    }
+
+    /**
+     * @brief Takes a snapshot by moving the values out of this tree.
+     * 
+     * @return FrozenTree<T> A snapshot holding the tree's values; the tree is left empty.
+     */
+    FrozenTree<T> freeze() && {
+        return FrozenTree<T>(std::move(*this));
+    }
+
+    /**
+     * @brief Ties the lifetime of an external buffer to this tree.
+     * 
+     * Node values that are views into a buffer (for example `StoryNodeView`s
+     * pointing into a memory-mapped file) stay valid for as long as the tree
+     * holds the buffer. Moving the tree moves the buffer with it.
+     * 
+     * @param buffer Shared ownership of the buffer the node values refer into.
+     */
+    void retainStorage(std::shared_ptr<const void> buffer) noexcept {
+        storage = std::move(buffer);
     }
 
     /**
@@ -494,21 +2329,169 @@ public:
      * @throw std::invalid_argument If node ID is invalid.
      */
     std::vector<int> getChildrenIDs(int nodeID) const {
-        auto nodeItr = nodeMap.find(nodeID);
-        if (nodeItr == nodeMap.end()) {
+        const Node<T>* node = findNode(nodeID);
+        if (!node) {
             std::stringstream errMsg;
             errMsg << "Node with ID " << nodeID << " does not exist";
             throw std::invalid_argument(errMsg.str());
         }
 
         std::vector<int> childrenIDs;
-        for (const auto& child : nodeItr->second->children) {
+        childrenIDs.reserve(node->children.size());
+        for (const auto& child : node->children) {
             childrenIDs.push_back(child->ID);
         }
 
         return childrenIDs;
     }
 
+    /**
+     * @brief Counts a node's children without building a list of them.
+     * 
+     * @param nodeID ID of the node to query.
+     * @return size_t Number of children.
+     * @throw std::invalid_argument If node ID is invalid.
+     */
+    size_t childCount(int nodeID) const {
+        const Node<T>* node = findNode(nodeID);
+        if (!node) {
+            std::stringstream errMsg;
+            errMsg << "Node with ID " << nodeID << " does not exist";
+            throw std::invalid_argument(errMsg.str());
+        }
+
+        return node->children.size();
+    }
+
+    /**
+     * @brief Iterates over a node's children in place.
+     * 
+     * Non-allocating alternative to `getChildrenIDs`: the returned range reads
+     * straight from the node's children list and yields each child's ID together
+     * with a reference to its value, so no follow-up `operator[]` lookup is needed.
+     * The range is invalidated by any change to the node's children.
+     * 
+     * @code
+     * for (auto child : tree.children(nodeID)) {
+     *     std::cout << child.id << ": " << child.value << "\n";
+     * }
+     * @endcode
+     * 
+     * @param nodeID ID of the node to query.
+     * @return ChildRange The node's children, in order.
+     * @throw std::invalid_argument If node ID is invalid.
+     */
+    ChildRange children(int nodeID) const {
+        const Node<T>* node = findNode(nodeID);
+        if (!node) {
+            std::stringstream errMsg;
+            errMsg << "Node with ID " << nodeID << " does not exist";
+            throw std::invalid_argument(errMsg.str());
+        }
+
+        return ChildRange(node->children.data(), node->children.data() + node->children.size());
+    }
+
+    /**
+     * @brief Iterates over the whole tree in pre-order, the order `serialize` writes.
+     * 
+     * @return TraversalRange<PreOrderIterator> The traversal; empty if the tree has no root.
+     */
+    TraversalRange<PreOrderIterator> preOrder() const noexcept {
+        return TraversalRange<PreOrderIterator>(root.get());
+    }
+
+    /**
+     * @brief Iterates over a subtree in pre-order.
+     * 
+     * @param nodeID ID of the subtree's root.
+     * @return TraversalRange<PreOrderIterator> The traversal.
+     * @throw std::invalid_argument If node ID is invalid.
+     */
+    TraversalRange<PreOrderIterator> preOrder(int nodeID) const {
+        return TraversalRange<PreOrderIterator>(checkedNode(nodeID));
+    }
+
+    /**
+     * @brief Iterates over the whole tree in post-order, each node after its children.
+     * 
+     * @return TraversalRange<PostOrderIterator> The traversal; empty if the tree has no root.
+     */
+    TraversalRange<PostOrderIterator> postOrder() const noexcept {
+        return TraversalRange<PostOrderIterator>(root.get());
+    }
+
+    /**
+     * @brief Iterates over a subtree in post-order.
+     * 
+     * @param nodeID ID of the subtree's root.
+     * @return TraversalRange<PostOrderIterator> The traversal.
+     * @throw std::invalid_argument If node ID is invalid.
+     */
+    TraversalRange<PostOrderIterator> postOrder(int nodeID) const {
+        return TraversalRange<PostOrderIterator>(checkedNode(nodeID));
+    }
+
+    /**
+     * @brief Iterates over the whole tree level by level, from the root down.
+     * 
+     * @return TraversalRange<LevelOrderIterator> The traversal; empty if the tree has no root.
+     */
+    TraversalRange<LevelOrderIterator> levelOrder() const noexcept {
+        return TraversalRange<LevelOrderIterator>(root.get());
+    }
+
+    /**
+     * @brief Iterates over a subtree level by level.
+     * 
+     * @param nodeID ID of the subtree's root.
+     * @return TraversalRange<LevelOrderIterator> The traversal.
+     * @throw std::invalid_argument If node ID is invalid.
+     */
+    TraversalRange<LevelOrderIterator> levelOrder(int nodeID) const {
+        return TraversalRange<LevelOrderIterator>(checkedNode(nodeID));
+    }
+
+    /**
+     * @brief Calls a visitor on every node of a subtree, in pre-order.
+     * 
+     * The visitor is a template parameter, so calls can be inlined. It is called
+     * as `visitor(NodeRef)` or, if it accepts one, `visitor(NodeRef, size_t depth)`
+     * with depth 0 at `nodeID`. A visitor returning bool can prune the walk:
+     * returning false skips the node's descendants.
+     * 
+     * @param nodeID ID of the subtree's root.
+     * @param visitor Callable invoked once per visited node.
+     * @throw std::invalid_argument If node ID is invalid.
+     */
+    template <typename F>
+    void visit(int nodeID, F&& visitor) const {
+        std::vector<std::pair<const Node<T>*, size_t>> stack;
+        stack.push_back({checkedNode(nodeID), 0});
+        while (!stack.empty()) {
+            auto [node, depth] = stack.back();
+            stack.pop_back();
+            if (!invokeVisitor(visitor, NodeRef{node->ID, node->value}, depth)) {
+                continue;
+            }
+            for (auto itr = node->children.rbegin(); itr != node->children.rend(); ++itr) {
+                stack.push_back({itr->get(), depth + 1});
+            }
+        }
+    }
+
+    /**
+     * @brief Calls a visitor on every node of the tree, in pre-order; see `visit(int, F&&)`.
+     * 
+     * @param visitor Callable invoked once per visited node; not called for an empty tree.
+     */
+    template <typename F>
+    void visit(F&& visitor) const {
+        if (root) {
+            visit(root->ID, std::forward<F>(visitor));
+        }
+    }
+
     /**
      * @brief Retrieves a node's value.
      * 
@@ -519,14 +2502,14 @@ public:
      * @throw std::invalid_argument If node ID is invalid.
      */
     const T& getValue(int nodeID) const {
-        auto nodeItr = nodeMap.find(nodeID);
-        if (nodeItr == nodeMap.end()) { 
+        const Node<T>* node = findNode(nodeID);
+        if (!node) { 
             std::stringstream errMsg; 
             errMsg << "Node with ID " << nodeID << " does not exist";
             throw std::invalid_argument(errMsg.str());
         }
 
-        return nodeItr->second->value;
+        return node->value;
     }
 
     /**
@@ -540,14 +2523,14 @@ public:
      * @throw std::invalid_argument If node is missing.
      */
     const T& operator[](int nodeID) const {
-        auto nodeItr = nodeMap.find(nodeID);
-        if (nodeItr == nodeMap.end()) {
+        const Node<T>* node = findNode(nodeID);
+        if (!node) {
             std::stringstream errMsg;
             errMsg << "Node with ID " << nodeID << " does not exist";
             throw std::invalid_argument(errMsg.str());
         }
 
-        return nodeItr->second->value;
+        return node->value;
     }
 
     /**
@@ -559,29 +2542,67 @@ public:
      * end-of-children tokens. The end-of-children tokens maintain
      * complete hierarchical information for accurate reconstruction.
      * 
+     * @param compactRuns Write consecutive end-of-children tokens as one "[X*n]" line.
+     *                    Smaller for deep chains, but only readers that know the run token can load it.
      * @return std::string The tree's serialized form.
      */
-    std::string serialize() const {
-        auto linearized = linearize();
-        std::string serialized;
+    std::string serialize(bool compactRuns = false) const {
+        std::ostringstream serialized;
+        serialize(serialized, compactRuns);
+        return serialized.str();
+    }
+
+    /**
+     * @brief Serializes the tree directly to an output stream.
+     * 
+     * Writes the same format as `serialize()` in a single pre-order walk,
+     * streaming each node to `os` as it is reached. No values are copied
+     * and no intermediate linearized vector or string is built, so peak
+     * memory stays at the size of the tree plus the stream's buffer.
+     * 
+     * @param os Stream to write to.
+     * @param compactRuns Write consecutive end-of-children tokens as one "[X*n]" line.
+     */
+    void serialize(std::ostream& os, bool compactRuns = false) const {
+        std::stack<const Node<T>*> stack;
         int nodeCount = 0;
+        size_t pendingEOC = 0; // end-of-children tokens not written yet, so a run can share a line
+        // if the root exists, push it onto the stack
+        if (root) {
+            stack.push(root.get());
+        }
+
+        while (!stack.empty()) {
+            const Node<T>* current = stack.top();
+            stack.pop();
 
-        for (const auto& optValue : linearized) {
             // Handle node values
-            if (optValue.has_value()) {
-                 // use new stream each loop
-                std::ostringstream textStream;
-                 // serialize the node
-                textStream << "[" << nodeCount++ << "]: " << optValue.value() << "\n";
-                // append the serialized node to the string
-                serialized += textStream.str();
+            if (current) {
+                writeEndOfChildren(os, pendingEOC, compactRuns);
+                os << "[" << nodeCount++ << "]: " << current->value << "\n";
+                // push a nullptr to mark where the node's end-of-children token goes
+                stack.push(nullptr);
+                for (auto itr = current->children.rbegin(); itr != current->children.rend(); ++itr) {
+                    stack.push(itr->get());
+                }
             // Handle end-of-children tokens
             } else {
-                serialized += "[X]\n";
+                ++pendingEOC;
             }
         }
+        writeEndOfChildren(os, pendingEOC, compactRuns);
+    }
 
-        return serialized;
+    /**
+     * @brief Appends the text format to a caller-provided buffer.
+     * 
+     * @param out Buffer to append to; existing contents are kept.
+     * @param compactRuns Write consecutive end-of-children tokens as one "[X*n]" line.
+     */
+    void serialize(std::string& out, bool compactRuns = false) const {
+        StringOutputBuffer buffer(out);
+        std::ostream os(&buffer);
+        serialize(os, compactRuns);
     }
 
     /**
@@ -589,76 +2610,329 @@ public:
      * 
      * Deserializes a tree from a string, restoring its structure.
      * Validates line formatting and node to end-of-children token
-     * ratios to ensure accurate reconstruction.
+     * ratios to ensure accurate reconstruction. The text is scanned
+     * in place, so any contiguous buffer (such as a mapped file) works.
      * 
      * @param serialized Serialized tree string.
      * @return Tree<T> The deserialized tree.
      * @throw std::invalid_argument for parsing errors or invalid serialization.
      */
-    static Tree<T> deserialize(const std::string& serialized) {
-        std::vector<std::optional<T>> linearized;
-        std::istringstream ss(serialized);
-        std::string line;
-        int nodeCount = 0, eocTokenCount = 0;
-        std::stringstream errMsg;
+    static Tree<T> deserialize(std::string_view serialized) {
+        return fromLinearized(parseLinearized(serialized));
+    }
 
-        try {
+    /**
+     * @brief Rebuilds a tree by reading its serialized form from a stream.
+     * 
+     * Consumes the stream line by line, so the serialized text never has to
+     * be held in memory as a whole.
+     * 
+     * @param is Stream positioned at the start of a serialized tree.
+     * @return Tree<T> The deserialized tree.
+     */
+    static Tree<T> deserialize(std::istream& is) {
+        return fromLinearized(parseLinearized(is));
+    }
 
-        while (std::getline(ss, line)) {
-            // Handle end-of-children tokens
-            if (line == "[X]") {
-                linearized.push_back(std::nullopt);
-                // Invalid hierarchical structure - too many end-of-children tokens
-                if (++eocTokenCount > nodeCount) {
-                    errMsg << "Invalid tree serialization: too many end-of-children tokens\n"
-                        << "A valid serialization should have one end-of-children token for every node.\n"
-                        << "Occurred during line " << nodeCount + eocTokenCount << " of the serialization.\n";
-                    throw std::invalid_argument(errMsg.str());
+    /**
+     * @brief Rebuilds a tree from its serialized form using several threads.
+     * 
+     * Large storylines are mostly made of independent subtrees under the root,
+     * and parsing their values dominates load time. This method first scans
+     * the text once, tracking depth through the "[X]" and "[X*n]" tokens, to find where
+     * each of the root's child subtrees begins and ends. The subtrees are then
+     * split into contiguous groups of roughly equal size, each group's lines are
+     * parsed on its own thread, and the results are stitched back under the
+     * root in their original order. IDs are assigned in pre-order, exactly as
+     * `deserialize` would assign them.
+     * 
+     * @param serialized Serialized tree text.
+     * @param threadCount Number of worker threads; 0 uses the hardware concurrency.
+     * @return Tree<T> The deserialized tree.
+     * @throw std::invalid_argument for parsing errors or invalid serialization.
+     */
+    static Tree<T> deserializeParallel(std::string_view serialized, unsigned threadCount = 0) {
+        TREE_METRICS_ADD(bytesParsed, serialized.size());
+        if (threadCount == 0) {
+            threadCount = std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        // Pre-scan: find the root line and the byte range of each root child subtree
+        std::string_view rootLine;
+        std::vector<std::pair<size_t, size_t>> subtrees; // [begin, end) byte offsets
+        size_t depth = 0, lineNumber = 0;
+        // a "[X*n]" run may close the last subtree and the root on one line, which then stays in that subtree's range
+        bool hasRoot = false, rootClosed = false, rootClosedWithSubtree = false;
+        LineScanner scanner(serialized);
+        std::vector<LineRecord> records;
+        while (scanner.scan(records)) {
+            for (const auto& record : records) {
+                size_t position = static_cast<size_t>(record.line.data() - serialized.data());
+                size_t next = std::min(position + record.line.size() + 1, serialized.size());
+                ++lineNumber;
+
+                if (rootClosed) {
+                    throw std::invalid_argument("Invalid tree serialization: lines found after the root's subtree ended, line "
+                                                + std::to_string(lineNumber));
                 }
-            // Handle node values
-            } else if (line.find("[") == 0 && line.find("]: ") != std::string::npos) {
-                std::string valuePart = line.substr(line.find("]: ") + 3);
-                // Compile time check to handle strings differently for serialization
-                // Since istream stops at the first whitespace; We want to capture the entire line
-                if constexpr (std::is_same<T, std::string>::value) {
-                    linearized.push_back(valuePart);
-                    nodeCount++;
-                // Handle fundamental types
-                // And custom types that implement the << and >> operators    
+                if (record.kind == LineRecord::EndOfChildren) {
+                    if (record.count > depth) {
+                        throw std::invalid_argument("Invalid tree serialization: too many end-of-children tokens, line "
+                                                    + std::to_string(lineNumber));
+                    }
+                    size_t closedFrom = depth;
+                    depth -= record.count;
+                    if (closedFrom > 1 && depth <= 1) {
+                        subtrees.back().second = next;
+                    }
+                    if (depth == 0) {
+                        rootClosed = true;
+                        rootClosedWithSubtree = closedFrom > 1;
+                    }
                 } else {
-                    std::istringstream valueStream(valuePart);
-                    T value;
-                    if (valueStream >> value) {
-                        linearized.push_back(value);
-                        nodeCount++;
-                    } else {
-                        errMsg << "Invalid tree serialization: unable to parse value\n"
-                            << "Unable to parse value from line while deserializing tree: " << line << "\n"
-                            << "Occurred during line " << nodeCount + eocTokenCount << " of the serialization.\n";
-                        throw std::invalid_argument(errMsg.str());
+                    if (depth == 0) {
+                        rootLine = record.line;
+                        hasRoot = true;
+                    } else if (depth == 1) {
+                        subtrees.emplace_back(position, next);
                     }
+                    ++depth;
                 }
-            // Invalid line format
-            } else {
-                errMsg << "Invalid tree serialization: invalid line format\n"
-                    << "Malformed line detected while deserializing tree: " << line << "\n"
-                    << "Expected format: '[n]: value' for nodes or '[X]' for end-of-children tokens.\n"
-                    << "Occurred during line " << nodeCount + eocTokenCount << " of the serialization.\n";
-                throw std::invalid_argument(errMsg.str());
             }
         }
+        if (depth != 0) {
+            throw std::invalid_argument("Invalid tree serialization: too few end-of-children tokens");
+        }
+        if (!hasRoot) {
+            return Tree<T>();
+        }
 
-        // Invalid hierarchical structure - too few end-of-children tokens
-        if (nodeCount != eocTokenCount) {
-            errMsg << "Invalid tree serialization: Too few end-of-children tokens\n"
-                << "A valid serialization should have one end-of-children token for every node.\n";
-            throw std::invalid_argument(errMsg.str());
+        // Split the subtrees into contiguous groups of roughly equal byte size
+        size_t groupCount = std::min<size_t>(threadCount, subtrees.size());
+        std::vector<std::pair<size_t, size_t>> groups; // [begin, end) byte offsets
+        if (groupCount > 0) {
+            size_t total = subtrees.back().second - subtrees.front().first;
+            size_t target = (total + groupCount - 1) / groupCount;
+            size_t groupBegin = subtrees.front().first;
+            for (const auto& subtree : subtrees) {
+                if (subtree.second - groupBegin >= target || &subtree == &subtrees.back()) {
+                    groups.emplace_back(groupBegin, subtree.second);
+                    groupBegin = subtree.second;
+                }
+            }
         }
-    } catch (std::exception& e) {
-        std::cerr << "Error: " << e.what() << std::endl;
+
+        // Parse each group on its own thread; the calling thread takes the first group
+        std::vector<std::vector<std::optional<T>>> parsed(groups.size());
+        std::vector<std::exception_ptr> errors(groups.size());
+        auto parseGroup = [&](size_t index) {
+            try {
+                parseLines(serialized.substr(groups[index].first, groups[index].second - groups[index].first),
+                           parsed[index]);
+            } catch (...) {
+                errors[index] = std::current_exception();
+            }
+        };
+        std::vector<std::thread> workers;
+        workers.reserve(groups.size());
+        for (size_t index = 1; index < groups.size(); ++index) {
+            workers.emplace_back(parseGroup, index);
+        }
+        if (!groups.empty()) {
+            parseGroup(0);
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        for (const auto& error : errors) {
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+
+        // Stitch the groups back together under the root, in order
+        std::vector<std::optional<T>> linearized;
+        parseLines(rootLine, linearized);
+        size_t totalSize = linearized.size() + 1;
+        for (const auto& group : parsed) {
+            totalSize += group.size();
+        }
+        linearized.reserve(totalSize);
+        for (auto& group : parsed) {
+            std::move(group.begin(), group.end(), std::back_inserter(linearized));
+            group = {};
+        }
+        if (!rootClosedWithSubtree) {
+            linearized.push_back(std::nullopt);
+        }
+        return fromLinearized(std::move(linearized));
+    }
+
+    /**
+     * @brief Serializes the tree to the compact binary format.
+     * 
+     * Writes the same pre-order layout as `serialize`, but each node is stored as a
+     * varint child count followed by a length-prefixed payload, so no end-of-children
+     * tokens or line parsing are needed to read it back. A run of single-child
+     * nodes shares one chain record, its payloads written back to back. Types providing
+     * `encodeBinary`/`decodeBinary` overloads control their own payload layout;
+     * std::string is stored raw, and any other type falls back to its << form.
+     * See BinaryCodec.h for the header, record and index footer layout.
+     * 
+     * @param withIndex Also write the index footer mapping node IDs to byte offsets.
+     * @return std::string The tree's binary serialized form.
+     */
+    std::string serializeBinary(bool withIndex = false) const {
+        std::string serialized;
+        serializeBinary(serialized, withIndex);
+        return serialized;
+    }
+
+    /**
+     * @brief Serializes the tree in the binary format directly to an output stream.
+     * 
+     * Walks the tree once, encoding nodes into a small reused buffer that is
+     * flushed to `os` whenever it fills, so no copy of the whole tree is built.
+     * With `withIndex`, each node's offset is noted on the way and the index
+     * footer is appended after the last node.
+     * 
+     * @param os Stream to write to; should be opened in binary mode.
+     * @param withIndex Also write the index footer mapping node IDs to byte offsets.
+     */
+    void serializeBinary(std::ostream& os, bool withIndex = false) const {
+        std::string buffer;
+        auto write = [&](std::string_view bytes) { os.write(bytes.data(), static_cast<std::streamsize>(bytes.size())); };
+        writeBinary(buffer, withIndex, 64 * 1024, write);
+        write(buffer);
+    }
+
+    /**
+     * @brief Appends the binary format to a caller-provided buffer.
+     * 
+     * Reusing one buffer across calls avoids allocating once its capacity has
+     * grown to fit the tree.
+     * 
+     * @param out Buffer to append to; existing contents are kept.
+     * @param withIndex Also write the index footer mapping node IDs to byte offsets.
+     */
+    void serializeBinary(std::string& out, bool withIndex = false) const {
+        writeBinary(out, withIndex, std::numeric_limits<size_t>::max(), [](std::string_view) {});
+    }
+
+    /**
+     * @brief Rebuilds a tree from its binary serialized form.
+     * 
+     * Reads the output of `serializeBinary`, converting child counts back into the
+     * linearized representation so reconstruction shares `delinearize` with the
+     * text format. Like `deserialize`, errors are reported to std::cerr and the
+     * nodes read up to that point are returned.
+     * 
+     * @param serialized Binary serialized tree data.
+     * @return Tree<T> The deserialized tree.
+     */
+    static Tree<T> deserializeBinary(std::string_view serialized) {
+        std::vector<std::optional<T>> linearized;
+        try {
+            parseBinary(serialized, linearized);
+        } catch (std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+        }
+
+        return fromLinearized(std::move(linearized));
+    }
+
+    /**
+     * @brief Rebuilds a tree from its text serialized form, rejecting any error.
+     * 
+     * Unlike `deserialize`, nothing is printed and no partial tree is returned,
+     * so callers can report failures their own way.
+     * 
+     * @param serialized Serialized tree string.
+     * @return Tree<T> The deserialized tree.
+     * @throw std::invalid_argument If the serialization is malformed.
+     */
+    static Tree<T> deserializeStrict(std::string_view serialized) {
+        std::vector<std::optional<T>> linearized;
+        parseText(serialized, linearized);
+        return fromLinearized(std::move(linearized));
+    }
+
+    /**
+     * @brief Rebuilds a tree from its binary serialized form, rejecting any error.
+     * 
+     * @param serialized Binary serialized tree data.
+     * @return Tree<T> The deserialized tree.
+     * @throw std::invalid_argument If the data is malformed or truncated.
+     */
+    static Tree<T> deserializeBinaryStrict(std::string_view serialized) {
+        std::vector<std::optional<T>> linearized;
+        parseBinary(serialized, linearized);
+        return fromLinearized(std::move(linearized));
+    }
+
+    /**
+     * @brief Serializes the tree to the block-compressed container format.
+     * 
+     * Much smaller than the other formats, since the text repeated across nodes
+     * is compressed away, and still readable node by node: LazyTree decompresses
+     * only the blocks holding the values it is asked for. See BlockCompression.h
+     * for the layout.
+     * 
+     * @param blockSize Uncompressed bytes of values per block; smaller blocks make
+     *                  random access cheaper, larger ones compress better.
+     * @return std::string The tree's compressed serialized form.
+     */
+    std::string serializeCompressed(size_t blockSize = COMPRESSED_TREE_BLOCK_SIZE) const {
+        std::string serialized;
+        writeCompressed(serialized, blockSize);
+        return serialized;
+    }
+
+    /**
+     * @brief Appends the compressed container format to a caller-provided buffer.
+     * 
+     * Like `serializeBinary(std::string&)`, reusing one buffer across calls avoids
+     * reallocating the output once its capacity fits the tree.
+     * 
+     * @param out Buffer to append to; existing contents are kept.
+     * @param blockSize Uncompressed bytes of values per block.
+     */
+    void serializeCompressed(std::string& out, size_t blockSize = COMPRESSED_TREE_BLOCK_SIZE) const {
+        writeCompressed(out, blockSize);
     }
 
-        return delinearize(linearized);
+    /**
+     * @brief Rebuilds a tree from its compressed serialized form.
+     * 
+     * Like `deserializeBinary`, errors are reported to std::cerr and the nodes
+     * read up to that point are returned. Not usable with values that view their
+     * input, such as StoryNodeView, since blocks are decompressed into a scratch buffer.
+     * 
+     * @param serialized Compressed tree data.
+     * @return Tree<T> The deserialized tree.
+     */
+    static Tree<T> deserializeCompressed(std::string_view serialized) {
+        std::vector<std::optional<T>> linearized;
+        try {
+            parseCompressed(serialized, linearized);
+        } catch (std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+        }
+
+        return fromLinearized(std::move(linearized));
+    }
+
+    /**
+     * @brief Rebuilds a tree from its compressed serialized form, rejecting any error.
+     * 
+     * @param serialized Compressed tree data.
+     * @return Tree<T> The deserialized tree.
+     * @throw std::invalid_argument If the data is malformed, truncated or fails a checksum.
+     */
+    static Tree<T> deserializeCompressedStrict(std::string_view serialized) {
+        std::vector<std::optional<T>> linearized;
+        parseCompressed(serialized, linearized);
+        return fromLinearized(std::move(linearized));
     }
 
     /**
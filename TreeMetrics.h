@@ -0,0 +1,322 @@
+/**
+ * Optional instrumentation for the load, save and navigation hot paths.
+ *
+ * Counters and latency histograms are compiled in only when TREE_METRICS is
+ * defined (e.g. build with -DTREE_METRICS). Otherwise the TREE_METRICS_ADD and
+ * TREE_METRICS_TIME hooks expand to nothing and their arguments are never
+ * evaluated, so the instrumented code is exactly what it would be without them.
+ *
+ * Recording is lock-free: every counter and histogram bucket is a relaxed
+ * atomic, so hooks may fire from any thread. Exporters pull the current
+ * values with `snapshotTreeMetrics`; nothing is pushed.
+ *
+ *
+ * HISTOGRAM BUCKETS
+ * _________________
+ *
+ * Latencies are recorded in nanoseconds into log-linear buckets, HDR-style:
+ * values below 16 get a bucket each, and every power of two above that is
+ * split into 8 equal sub-buckets. Any recorded value is therefore known to
+ * within 12.5%, across the full 64-bit range, in a fixed 496 buckets.
+ */
+
+#ifndef TREEMETRICS_H
+#define TREEMETRICS_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+#if defined(TREE_METRICS)
+inline constexpr bool TREE_METRICS_ENABLED = true;
+#else
+inline constexpr bool TREE_METRICS_ENABLED = false;
+#endif
+
+/**
+ * @brief Monotonic event or byte counter.
+ */
+class MetricCounter {
+public:
+    void add(std::uint64_t amount) noexcept { value.fetch_add(amount, std::memory_order_relaxed); }
+
+    std::uint64_t load() const noexcept { return value.load(std::memory_order_relaxed); }
+
+    void reset() noexcept { value.store(0, std::memory_order_relaxed); }
+
+private:
+    std::atomic<std::uint64_t> value{0};
+};
+
+/**
+ * @brief Point-in-time copy of a LatencyHistogram.
+ */
+struct HistogramSnapshot {
+    std::uint64_t count = 0;
+    std::uint64_t sum = 0; // Total of all recorded values, in nanoseconds
+    std::uint64_t min = 0;
+    std::uint64_t max = 0;
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> buckets; // (bucket upper bound, count), non-empty buckets only
+
+    /**
+     * @brief Estimates a percentile from the bucket counts.
+     *
+     * @param quantile Fraction of recorded values to rank below the result, from 0 to 1.
+     * @return std::uint64_t Upper bound of the bucket holding that rank, clamped to `max`, or 0 if empty.
+     */
+    std::uint64_t percentile(double quantile) const noexcept {
+        if (count == 0) {
+            return 0;
+        }
+        double clamped = std::min(std::max(quantile, 0.0), 1.0);
+        std::uint64_t rank = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(clamped * static_cast<double>(count) + 0.5));
+        std::uint64_t seen = 0;
+        for (const auto& bucket : buckets) {
+            seen += bucket.second;
+            if (seen >= rank) {
+                return std::min(bucket.first, max);
+            }
+        }
+        return max;
+    }
+
+    double mean() const noexcept {
+        return count == 0 ? 0.0 : static_cast<double>(sum) / static_cast<double>(count);
+    }
+};
+
+/**
+ * @brief Lock-free log-linear histogram of nanosecond latencies.
+ */
+class LatencyHistogram {
+public:
+    static constexpr unsigned SUB_BUCKET_BITS = 3;
+    static constexpr unsigned SUB_BUCKETS = 1u << SUB_BUCKET_BITS;
+    static constexpr unsigned LINEAR_LIMIT = SUB_BUCKETS * 2; // Values below this get a bucket each
+    static constexpr unsigned BUCKET_COUNT = LINEAR_LIMIT + (64 - SUB_BUCKET_BITS - 1) * SUB_BUCKETS;
+
+    /**
+     * @brief Maps a value to its bucket.
+     *
+     * @param value Value in nanoseconds.
+     * @return unsigned Index of the bucket counting that value.
+     */
+    static unsigned bucketOf(std::uint64_t value) noexcept {
+        if (value < LINEAR_LIMIT) {
+            return static_cast<unsigned>(value);
+        }
+#if defined(_MSC_VER) && !defined(__clang__)
+        unsigned long highest;
+        _BitScanReverse64(&highest, value);
+        unsigned exponent = static_cast<unsigned>(highest);
+#else
+        unsigned exponent = 63 - static_cast<unsigned>(__builtin_clzll(value));
+#endif
+        unsigned subBucket = static_cast<unsigned>(value >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1);
+        return LINEAR_LIMIT + (exponent - SUB_BUCKET_BITS - 1) * SUB_BUCKETS + subBucket;
+    }
+
+    /**
+     * @brief Largest value counted by a bucket.
+     *
+     * @param bucket Index of the bucket.
+     * @return std::uint64_t Inclusive upper bound of the bucket.
+     */
+    static std::uint64_t bucketUpperBound(unsigned bucket) noexcept {
+        if (bucket < LINEAR_LIMIT) {
+            return bucket;
+        }
+        unsigned exponent = (bucket - LINEAR_LIMIT) / SUB_BUCKETS + SUB_BUCKET_BITS + 1;
+        std::uint64_t subBucket = (bucket - LINEAR_LIMIT) % SUB_BUCKETS;
+        std::uint64_t width = std::uint64_t(1) << (exponent - SUB_BUCKET_BITS);
+        return (std::uint64_t(1) << exponent) + (subBucket + 1) * width - 1;
+    }
+
+    void record(std::uint64_t nanoseconds) noexcept {
+        counts[bucketOf(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+        total.fetch_add(1, std::memory_order_relaxed);
+        sum.fetch_add(nanoseconds, std::memory_order_relaxed);
+        std::uint64_t seen = min.load(std::memory_order_relaxed);
+        while (nanoseconds < seen && !min.compare_exchange_weak(seen, nanoseconds, std::memory_order_relaxed)) {
+        }
+        seen = max.load(std::memory_order_relaxed);
+        while (nanoseconds > seen && !max.compare_exchange_weak(seen, nanoseconds, std::memory_order_relaxed)) {
+        }
+    }
+
+    /**
+     * @brief Copies the histogram.
+     *
+     * Buckets are read one at a time while recording may continue, so a
+     * snapshot taken under load can be off by the few values recorded meanwhile.
+     *
+     * @return HistogramSnapshot The current counts.
+     */
+    HistogramSnapshot snapshot() const {
+        HistogramSnapshot copy;
+        copy.count = total.load(std::memory_order_relaxed);
+        copy.sum = sum.load(std::memory_order_relaxed);
+        copy.min = copy.count == 0 ? 0 : min.load(std::memory_order_relaxed);
+        copy.max = max.load(std::memory_order_relaxed);
+        for (unsigned bucket = 0; bucket < BUCKET_COUNT; ++bucket) {
+            std::uint64_t count = counts[bucket].load(std::memory_order_relaxed);
+            if (count != 0) {
+                copy.buckets.emplace_back(bucketUpperBound(bucket), count);
+            }
+        }
+        return copy;
+    }
+
+    void reset() noexcept {
+        for (auto& count : counts) {
+            count.store(0, std::memory_order_relaxed);
+        }
+        total.store(0, std::memory_order_relaxed);
+        sum.store(0, std::memory_order_relaxed);
+        min.store(std::numeric_limits<std::uint64_t>::max(), std::memory_order_relaxed);
+        max.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    std::array<std::atomic<std::uint64_t>, BUCKET_COUNT> counts{};
+    std::atomic<std::uint64_t> total{0};
+    std::atomic<std::uint64_t> sum{0};
+    std::atomic<std::uint64_t> min{std::numeric_limits<std::uint64_t>::max()};
+    std::atomic<std::uint64_t> max{0};
+};
+
+/**
+ * @brief Records the lifetime of a scope into a LatencyHistogram.
+ */
+class ScopedLatency {
+public:
+    explicit ScopedLatency(LatencyHistogram& histogram) noexcept
+        : histogram(histogram), start(std::chrono::steady_clock::now()) {}
+
+    ScopedLatency(const ScopedLatency&) = delete;
+    ScopedLatency& operator=(const ScopedLatency&) = delete;
+
+    ~ScopedLatency() {
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+        histogram.record(static_cast<std::uint64_t>(elapsed.count()));
+    }
+
+private:
+    LatencyHistogram& histogram;
+    std::chrono::steady_clock::time_point start;
+};
+
+/**
+ * @brief Every metric recorded by the instrumented code paths.
+ */
+struct TreeMetrics {
+    // Tree deserialization, across the text, binary and compressed formats
+    MetricCounter bytesParsed;      // Serialized bytes handed to a decoder
+    MetricCounter linesParsed;      // Text lines scanned, node values and "[X]" tokens alike
+    MetricCounter nodesBuilt;       // Nodes created by delinearization
+    LatencyHistogram parseLatency;  // Decoding serialized data into linearized form
+    LatencyHistogram delinearizeLatency;
+
+    // nodeMap lookups by ID; hits are lookups minus both kinds of miss
+    MetricCounter nodeLookups;
+    MetricCounter nodeLookupsRemoved;    // ID was issued, but the node has been removed
+    MetricCounter nodeLookupsOutOfRange; // ID was never issued
+
+    // Storyline files
+    MetricCounter fileBytesRead;
+    MetricCounter fileBytesWritten;
+    LatencyHistogram loadLatency; // Whole load, including any journal replay
+    LatencyHistogram saveLatency;
+
+    // Navigation: from a choice being made to the next node being shown
+    LatencyHistogram turnLatency;
+};
+
+/**
+ * @brief The process-wide metrics that the TREE_METRICS hooks record into.
+ *
+ * @return TreeMetrics& The shared instance.
+ */
+inline TreeMetrics& treeMetrics() noexcept {
+    static TreeMetrics metrics;
+    return metrics;
+}
+
+/**
+ * @brief Point-in-time copy of every metric, keyed by exporter-friendly names.
+ */
+struct TreeMetricsSnapshot {
+    std::vector<std::pair<const char*, std::uint64_t>> counters;
+    std::vector<std::pair<const char*, HistogramSnapshot>> histograms; // values in nanoseconds
+};
+
+/**
+ * @brief Reads the current value of every metric.
+ *
+ * Always safe to call; without TREE_METRICS every value is zero.
+ *
+ * @return TreeMetricsSnapshot Counters and histograms, in a fixed order.
+ */
+inline TreeMetricsSnapshot snapshotTreeMetrics() {
+    const TreeMetrics& metrics = treeMetrics();
+    TreeMetricsSnapshot snapshot;
+    snapshot.counters = {
+        {"tree_bytes_parsed", metrics.bytesParsed.load()},
+        {"tree_lines_parsed", metrics.linesParsed.load()},
+        {"tree_nodes_built", metrics.nodesBuilt.load()},
+        {"tree_node_lookups", metrics.nodeLookups.load()},
+        {"tree_node_lookups_removed", metrics.nodeLookupsRemoved.load()},
+        {"tree_node_lookups_out_of_range", metrics.nodeLookupsOutOfRange.load()},
+        {"storyline_file_bytes_read", metrics.fileBytesRead.load()},
+        {"storyline_file_bytes_written", metrics.fileBytesWritten.load()},
+    };
+    snapshot.histograms = {
+        {"tree_parse_latency_ns", metrics.parseLatency.snapshot()},
+        {"tree_delinearize_latency_ns", metrics.delinearizeLatency.snapshot()},
+        {"storyline_load_latency_ns", metrics.loadLatency.snapshot()},
+        {"storyline_save_latency_ns", metrics.saveLatency.snapshot()},
+        {"story_turn_latency_ns", metrics.turnLatency.snapshot()},
+    };
+    return snapshot;
+}
+
+/**
+ * @brief Zeroes every metric, e.g. between benchmark runs.
+ */
+inline void resetTreeMetrics() noexcept {
+    TreeMetrics& metrics = treeMetrics();
+    for (MetricCounter* counter : {&metrics.bytesParsed, &metrics.linesParsed, &metrics.nodesBuilt, &metrics.nodeLookups,
+                                   &metrics.nodeLookupsRemoved, &metrics.nodeLookupsOutOfRange, &metrics.fileBytesRead,
+                                   &metrics.fileBytesWritten}) {
+        counter->reset();
+    }
+    for (LatencyHistogram* histogram : {&metrics.parseLatency, &metrics.delinearizeLatency, &metrics.loadLatency,
+                                        &metrics.saveLatency, &metrics.turnLatency}) {
+        histogram->reset();
+    }
+}
+
+#define TREE_METRICS_CONCAT_(a, b) a##b
+#define TREE_METRICS_CONCAT(a, b) TREE_METRICS_CONCAT_(a, b)
+
+#if defined(TREE_METRICS)
+// Adds `amount` to the named TreeMetrics counter.
+#define TREE_METRICS_ADD(counter, amount) treeMetrics().counter.add(static_cast<std::uint64_t>(amount))
+// Records the time until the end of the enclosing scope into the named TreeMetrics histogram.
+#define TREE_METRICS_TIME(histogram) ScopedLatency TREE_METRICS_CONCAT(treeMetricsTimer, __LINE__)(treeMetrics().histogram)
+#else
+#define TREE_METRICS_ADD(counter, amount) ((void)0)
+#define TREE_METRICS_TIME(histogram) ((void)0)
+#endif
+
+#endif // TREEMETRICS_H
\ No newline at end of file
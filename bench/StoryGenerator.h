@@ -0,0 +1,112 @@
+/**
+ * Synthetic storylines for benchmarks.
+ *
+ * Builds a complete tree of StoryNodes from three knobs: how many choices
+ * each node offers, how many choices deep the story goes, and how many
+ * characters of text each node carries. The text is pseudo-random but
+ * seeded, so every run of a benchmark works on exactly the same story.
+ */
+
+#ifndef STORYGENERATOR_H
+#define STORYGENERATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "StoryNode.h"
+#include "Tree.h"
+
+/**
+ * @brief Shape of a synthetic storyline.
+ */
+struct StoryShape {
+    size_t branching = 3;     // Children of every non-ending node
+    size_t depth = 6;         // Choices from the root to every ending
+    size_t payloadSize = 64;  // Characters of text per node, split between action and outcome
+    std::uint32_t seed = 1;   // Seed for the generated text
+
+    /**
+     * @brief Counts the nodes a story of this shape has.
+     *
+     * @return size_t branching^0 + branching^1 + ... + branching^depth.
+     */
+    size_t nodeCount() const noexcept {
+        size_t total = 0;
+        size_t level = 1;
+        for (size_t i = 0; i <= depth; ++i) {
+            total += level;
+            level *= branching;
+        }
+        return total;
+    }
+};
+
+/**
+ * @brief Generates deterministic, word-like text.
+ *
+ * @param rng Source of randomness.
+ * @param length Number of characters to produce.
+ * @return std::string Lower-case words separated by single spaces.
+ */
+inline std::string generateText(std::mt19937& rng, size_t length) {
+    std::uniform_int_distribution<int> letter('a', 'z');
+    std::uniform_int_distribution<int> wordLength(2, 9);
+    std::string text;
+    text.reserve(length);
+    int untilSpace = wordLength(rng);
+    while (text.size() < length) {
+        if (untilSpace-- == 0 && text.size() + 1 < length) {
+            text.push_back(' ');
+            untilSpace = wordLength(rng);
+        } else {
+            text.push_back(static_cast<char>(letter(rng)));
+        }
+    }
+    return text;
+}
+
+/**
+ * @brief Generates one node's action and outcome.
+ *
+ * @param rng Source of randomness.
+ * @param payloadSize Combined length of the action and outcome; the action gets a quarter.
+ * @return StoryNode The generated node.
+ */
+inline StoryNode generateStoryNode(std::mt19937& rng, size_t payloadSize) {
+    size_t actionSize = payloadSize / 4;
+    StoryNode node;
+    node.action = generateText(rng, actionSize == 0 ? 1 : actionSize);
+    node.outcome = generateText(rng, payloadSize > actionSize + 1 ? payloadSize - actionSize : 1);
+    return node;
+}
+
+/**
+ * @brief Builds a complete storyline of the given shape.
+ *
+ * Nodes are appended level by level, so every level's IDs are contiguous.
+ *
+ * @param shape Branching factor, depth, payload size and seed.
+ * @return Tree<StoryNode> The generated storyline.
+ */
+inline Tree<StoryNode> generateStory(const StoryShape& shape) {
+    std::mt19937 rng(shape.seed);
+    Tree<StoryNode> tree;
+    std::vector<int> level{tree.setRoot(generateStoryNode(rng, shape.payloadSize))};
+    for (size_t d = 0; d < shape.depth; ++d) {
+        std::vector<int> next;
+        next.reserve(level.size() * shape.branching);
+        for (int parentID : level) {
+            for (size_t i = 0; i < shape.branching; ++i) {
+                next.push_back(tree.appendNode(parentID, generateStoryNode(rng, shape.payloadSize)));
+            }
+        }
+        level = std::move(next);
+    }
+    return tree;
+}
+
+#endif // STORYGENERATOR_H
\ No newline at end of file
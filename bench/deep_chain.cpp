@@ -0,0 +1,117 @@
+/**
+ * Stress test for very deep trees.
+ *
+ * Builds a single chain of nodes, each the only child of the one before, and
+ * runs it through every whole-tree operation: serialization in both formats,
+ * deserialization, traversals, freezing, lazy indexing, subtree removal and destruction.
+ * Any recursive walk would overflow the call stack long before the end of the
+ * chain, so finishing at all is the test; the timings are printed as a guide.
+ *
+ * Built by the deep_chain CMake target:
+ *     cmake -S . -B build && cmake --build build --target deep_chain
+ * Run with an optional chain length (default 1,000,000):
+ *     ./build/deep_chain 5000000
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <utility>
+
+#include "FrozenTree.h"
+#include "LazyTree.h"
+#include "Tree.h"
+
+using Clock = std::chrono::steady_clock;
+
+// Runs `step`, printing how long it took.
+template <typename F>
+void timed(const char* label, F&& step) {
+    auto start = Clock::now();
+    step();
+    auto elapsed = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    std::cout << label << ": " << elapsed << " ms" << std::endl;
+}
+
+// Exits with an error if a check fails, so the program can be used from scripts.
+void require(bool condition, const char* what) {
+    if (!condition) {
+        std::cerr << "deep_chain: " << what << std::endl;
+        std::exit(1);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    int depth = argc > 1 ? std::atoi(argv[1]) : 1000000;
+    require(depth > 1, "chain length must be at least 2");
+    std::cout << "chain of " << depth << " nodes" << std::endl;
+
+    Tree<int> tree;
+    timed("build", [&]() {
+        int current = tree.setRoot(0);
+        for (int i = 1; i < depth; ++i) {
+            current = tree.appendNode(current, i);
+        }
+    });
+
+    std::string text, binary;
+    timed("serialize", [&]() { text = tree.serialize(); });
+    timed("serializeBinary", [&]() { binary = tree.serializeBinary(true); });
+
+    timed("deserialize", [&]() {
+        Tree<int> copy = Tree<int>::deserialize(text);
+        require(copy.getValue(depth - 1) == depth - 1, "text round trip lost nodes");
+    });
+    timed("deserializeBinary", [&]() {
+        Tree<int> copy = Tree<int>::deserializeBinary(binary);
+        require(copy.getValue(depth - 1) == depth - 1, "binary round trip lost nodes");
+    });
+    timed("deserializeParallel", [&]() {
+        Tree<int> copy = Tree<int>::deserializeParallel(text);
+        require(copy.getValue(depth - 1) == depth - 1, "parallel round trip lost nodes");
+    });
+
+    timed("traversals", [&]() {
+        long long sum = 0;
+        for (auto node : tree.preOrder()) {
+            sum += node.value;
+        }
+        for (auto node : tree.postOrder()) {
+            sum += node.value;
+        }
+        for (auto node : tree.levelOrder()) {
+            sum += node.value;
+        }
+        size_t deepest = 0;
+        tree.visit([&](Tree<int>::NodeRef, size_t depth) { deepest = depth; });
+        require(sum == 3LL * depth * (depth - 1) / 2, "traversal missed nodes");
+        require(deepest == static_cast<size_t>(depth - 1), "visit depth is wrong");
+    });
+
+    timed("freeze and thaw", [&]() {
+        FrozenTree<int> frozen = tree.freeze();
+        require(frozen.subtreeSize(0) == static_cast<size_t>(depth), "frozen subtree size is wrong");
+        Tree<int> thawed = frozen.thaw();
+        require(thawed.childCount(depth - 2) == 1, "thawed chain is broken");
+    });
+
+    timed("lazy index", [&]() {
+        LazyTree<int> lazy(binary, 16);
+        require(lazy.subtreeSize(1) == static_cast<size_t>(depth - 1), "lazy subtree size is wrong");
+        require(lazy[depth - 1] == depth - 1, "lazy value is wrong");
+    });
+
+    timed("removeNode", [&]() {
+        tree.removeNode(1);
+        require(tree.childCount(0) == 0, "chain was not removed");
+    });
+
+    timed("destroy", [&]() {
+        Tree<int> doomed = Tree<int>::deserializeBinary(binary);
+        // the chain is released here, when `doomed` goes out of scope
+    });
+
+    std::cout << "ok" << std::endl;
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,309 @@
+/**
+ * Google Benchmark suite for Tree<StoryNode> and the storyline helpers.
+ *
+ * Every benchmark runs on synthetic storylines from StoryGenerator.h, one per
+ * shape below, and on varian_wrynn.txt as a real-world fixture. Shapes are
+ * given as (branching, depth, payload size) and are part of each benchmark's
+ * name, e.g. BM_Deserialize/branching:4/depth:7/payload:64. Item counts are
+ * nodes, so the reported items_per_second is a per-node rate that can be
+ * compared across shapes.
+ *
+ * Built by the tree_benchmarks CMake target when Google Benchmark is installed:
+ *     cmake -S . -B build && cmake --build build --target tree_benchmarks
+ * Run from the repository root, so the fixture can be found:
+ *     ./build/tree_benchmarks --benchmark_filter=Deserialize
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <filesystem>
+#include <map>
+#include <optional>
+#include <random>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "StoryGenerator.h"
+#include "StoryNode.h"
+#include "Tree.h"
+#include "utils.h"
+
+// Gives the benchmarks access to Tree's private linearize and delinearize.
+struct TreeBenchAccess {
+    static std::vector<std::optional<StoryNode>> linearize(const Tree<StoryNode>& tree) {
+        return tree.linearize();
+    }
+
+    static Tree<StoryNode> delinearize(const std::vector<std::optional<StoryNode>>& linearized) {
+        return Tree<StoryNode>::delinearize(linearized);
+    }
+};
+
+namespace {
+
+const char* FIXTURE_PATH = "varian_wrynn.txt";
+
+// Storylines are generated once per shape and shared by every benchmark that uses it.
+const Tree<StoryNode>& syntheticStory(const benchmark::State& state) {
+    static std::map<std::tuple<int64_t, int64_t, int64_t>, Tree<StoryNode>> stories;
+    auto key = std::make_tuple(state.range(0), state.range(1), state.range(2));
+    auto found = stories.find(key);
+    if (found == stories.end()) {
+        StoryShape shape;
+        shape.branching = static_cast<size_t>(state.range(0));
+        shape.depth = static_cast<size_t>(state.range(1));
+        shape.payloadSize = static_cast<size_t>(state.range(2));
+        found = stories.emplace(key, generateStory(shape)).first;
+    }
+    return found->second;
+}
+
+// Loaded once; an empty tree if the benchmarks aren't run from the repository root.
+const Tree<StoryNode>& fixtureStory() {
+    static const Tree<StoryNode> story = []() {
+        StoryResult<Tree<StoryNode>> loaded = tryLoadStoryline(FIXTURE_PATH);
+        return loaded ? std::move(loaded.value) : Tree<StoryNode>();
+    }();
+    return story;
+}
+
+// Node count of a tree whose IDs were handed out without removals.
+size_t nodeCount(const Tree<StoryNode>& tree) {
+    size_t count = 0;
+    for (auto node : tree.preOrder()) {
+        (void)node;
+        ++count;
+    }
+    return count;
+}
+
+// Picks the synthetic story for the benchmark's arguments, or the fixture if it has none.
+const Tree<StoryNode>* storyFor(benchmark::State& state) {
+    if (state.range(0) != 0) {
+        return &syntheticStory(state);
+    }
+    const Tree<StoryNode>& fixture = fixtureStory();
+    if (fixture.getRootID() == -1) {
+        state.SkipWithError("varian_wrynn.txt not found; run from the repository root");
+        return nullptr;
+    }
+    return &fixture;
+}
+
+std::filesystem::path scratchPath(const char* name) {
+    return std::filesystem::temp_directory_path() / name;
+}
+
+// Registers a benchmark for every synthetic shape, plus the fixture as (0, 0, 0).
+void storyShapes(benchmark::internal::Benchmark* bench) {
+    bench->ArgNames({"branching", "depth", "payload"});
+    bench->Args({0, 0, 0});      // varian_wrynn.txt
+    bench->Args({2, 12, 64});    // narrow and deep, 8k nodes
+    bench->Args({4, 7, 64});     // typical, 22k nodes
+    bench->Args({8, 5, 64});     // wide and shallow, 37k nodes
+    bench->Args({4, 7, 1024});   // long passages, 22k nodes
+    bench->Args({1, 4096, 64});  // a single 4k-node chain
+}
+
+void BM_Serialize(benchmark::State& state) {
+    const Tree<StoryNode>* tree = storyFor(state);
+    if (!tree) {
+        return;
+    }
+    std::string out;
+    for (auto _ : state) {
+        out.clear();
+        tree->serialize(out);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(nodeCount(*tree)));
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(out.size()));
+}
+BENCHMARK(BM_Serialize)->Apply(storyShapes);
+
+void BM_Deserialize(benchmark::State& state) {
+    const Tree<StoryNode>* tree = storyFor(state);
+    if (!tree) {
+        return;
+    }
+    std::string serialized = tree->serialize();
+    for (auto _ : state) {
+        Tree<StoryNode> copy = Tree<StoryNode>::deserialize(serialized);
+        benchmark::DoNotOptimize(copy.getRootID());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(nodeCount(*tree)));
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(serialized.size()));
+}
+BENCHMARK(BM_Deserialize)->Apply(storyShapes);
+
+void BM_Linearize(benchmark::State& state) {
+    const Tree<StoryNode>* tree = storyFor(state);
+    if (!tree) {
+        return;
+    }
+    for (auto _ : state) {
+        std::vector<std::optional<StoryNode>> linearized = TreeBenchAccess::linearize(*tree);
+        benchmark::DoNotOptimize(linearized.data());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(nodeCount(*tree)));
+}
+BENCHMARK(BM_Linearize)->Apply(storyShapes);
+
+void BM_Delinearize(benchmark::State& state) {
+    const Tree<StoryNode>* tree = storyFor(state);
+    if (!tree) {
+        return;
+    }
+    std::vector<std::optional<StoryNode>> linearized = TreeBenchAccess::linearize(*tree);
+    for (auto _ : state) {
+        Tree<StoryNode> copy = TreeBenchAccess::delinearize(linearized);
+        benchmark::DoNotOptimize(copy.getRootID());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(nodeCount(*tree)));
+}
+BENCHMARK(BM_Delinearize)->Apply(storyShapes);
+
+// Rebuilds the story one appendNode at a time, parents before children.
+void BM_AppendNode(benchmark::State& state) {
+    const Tree<StoryNode>* tree = storyFor(state);
+    if (!tree) {
+        return;
+    }
+    std::vector<int> order; // original IDs, in pre-order
+    std::vector<int> parents(nodeCount(*tree), -1);
+    for (auto node : tree->preOrder()) {
+        order.push_back(node.id);
+        for (int childID : tree->getChildrenIDs(node.id)) {
+            parents[childID] = node.id;
+        }
+    }
+    std::vector<int> copyIDs(parents.size(), -1); // original ID -> ID in the copy
+    for (auto _ : state) {
+        Tree<StoryNode> copy;
+        copyIDs[order.front()] = copy.setRoot((*tree)[order.front()]);
+        for (size_t i = 1; i < order.size(); ++i) {
+            copyIDs[order[i]] = copy.appendNode(copyIDs[parents[order[i]]], (*tree)[order[i]]);
+        }
+        benchmark::DoNotOptimize(copyIDs.data());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(order.size()));
+}
+BENCHMARK(BM_AppendNode)->Apply(storyShapes);
+
+// Removes every branch under the root from a fresh copy; building the copy isn't timed.
+void BM_RemoveNode(benchmark::State& state) {
+    const Tree<StoryNode>* tree = storyFor(state);
+    if (!tree) {
+        return;
+    }
+    std::string serialized = tree->serializeBinary();
+    for (auto _ : state) {
+        state.PauseTiming();
+        // the copy's IDs are in pre-order, which may differ from the original's
+        Tree<StoryNode> copy = Tree<StoryNode>::deserializeBinary(serialized);
+        std::vector<int> branches = copy.getChildrenIDs(copy.getRootID());
+        state.ResumeTiming();
+        for (int branchID : branches) {
+            copy.removeNode(branchID);
+        }
+        benchmark::DoNotOptimize(copy.getRootID());
+        state.PauseTiming();
+        // the copy is destroyed here, outside the timed region
+        copy = Tree<StoryNode>();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(nodeCount(*tree) - 1));
+}
+BENCHMARK(BM_RemoveNode)->Apply(storyShapes);
+
+void BM_GetChildrenIDs(benchmark::State& state) {
+    const Tree<StoryNode>* tree = storyFor(state);
+    if (!tree) {
+        return;
+    }
+    size_t count = nodeCount(*tree);
+    for (auto _ : state) {
+        size_t children = 0;
+        for (size_t id = 0; id < count; ++id) {
+            children += tree->getChildrenIDs(static_cast<int>(id)).size();
+        }
+        benchmark::DoNotOptimize(children);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(count));
+}
+BENCHMARK(BM_GetChildrenIDs)->Apply(storyShapes);
+
+// Looks nodes up in a shuffled order, so the cost of scattered accesses shows up.
+void BM_IndexOperator(benchmark::State& state) {
+    const Tree<StoryNode>* tree = storyFor(state);
+    if (!tree) {
+        return;
+    }
+    std::vector<int> ids(nodeCount(*tree));
+    for (size_t id = 0; id < ids.size(); ++id) {
+        ids[id] = static_cast<int>(id);
+    }
+    std::shuffle(ids.begin(), ids.end(), std::mt19937(7));
+    for (auto _ : state) {
+        size_t length = 0;
+        for (int id : ids) {
+            length += (*tree)[id].outcome.size();
+        }
+        benchmark::DoNotOptimize(length);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(ids.size()));
+}
+BENCHMARK(BM_IndexOperator)->Apply(storyShapes);
+
+// Writes the story in the format given by the fourth argument (0 = Text, 1 = Binary, 2 = Compressed).
+void BM_SaveStoryline(benchmark::State& state) {
+    const Tree<StoryNode>* tree = storyFor(state);
+    if (!tree) {
+        return;
+    }
+    StoryFormat format = static_cast<StoryFormat>(state.range(3));
+    std::filesystem::path path = scratchPath("tree_benchmarks_save.story");
+    for (auto _ : state) {
+        saveStoryline(*tree, path, format);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(nodeCount(*tree)));
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(std::filesystem::file_size(path)));
+    std::filesystem::remove(path);
+}
+
+// Reads the story back in the format given by the fourth argument.
+void BM_LoadStoryline(benchmark::State& state) {
+    const Tree<StoryNode>* tree = storyFor(state);
+    if (!tree) {
+        return;
+    }
+    std::filesystem::path path = scratchPath("tree_benchmarks_load.story");
+    saveStoryline(*tree, path, static_cast<StoryFormat>(state.range(3)));
+    for (auto _ : state) {
+        Tree<StoryNode> loaded = loadStoryline(path);
+        benchmark::DoNotOptimize(loaded.getRootID());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(nodeCount(*tree)));
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(std::filesystem::file_size(path)));
+    std::filesystem::remove(path);
+}
+
+// File benchmarks cover fewer shapes, each in every on-disk format.
+void storyFiles(benchmark::internal::Benchmark* bench) {
+    bench->ArgNames({"branching", "depth", "payload", "format"});
+    for (int64_t format = 0; format <= 2; ++format) {
+        bench->Args({0, 0, 0, format});
+        bench->Args({4, 7, 64, format});
+        bench->Args({4, 7, 1024, format});
+    }
+}
+BENCHMARK(BM_SaveStoryline)->Apply(storyFiles);
+BENCHMARK(BM_LoadStoryline)->Apply(storyFiles);
+
+} // namespace
+
+BENCHMARK_MAIN();
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include "StoryNode.h"
 #include "Tree.h"
+#include "TreeMetrics.h"
 #include "utils.h"
 
 int main() {
@@ -9,39 +10,47 @@ int main() {
     Tree<StoryNode> storyTree = loadStoryline("varian_wrynn.txt");
     int currentNodeID = storyTree.getRootID();
     
-    // Main Game loop
-    while (true) {
+    // Shows the current node and its choices; timed as one turn when TREE_METRICS is on
+    auto showTurn = [&]() {
+        TREE_METRICS_TIME(turnLatency);
         // Displays the current story node to the user
         std::cout << "-------------------------------------------\n";
         std::cout << "Story:\n";
         std::cout << storyTree[currentNodeID].outcome << "\n";
         std::cout << "-------------------------------------------\n";
 
-        // Get children IDs and display options ffor the user to pick from
-        std::vector<int> childrenIDs = storyTree.getChildrenIDs(currentNodeID);
-        if (childrenIDs.empty()) {
-            std::cout << "End of story reached. Thanks for playing!\n";
-            break;
+        // Get the children and display options ffor the user to pick from
+        auto children = storyTree.children(currentNodeID);
+        if (!children.empty()) {
+            std::cout << "Choose your next action:\n";
+            for (size_t i = 0; i < children.size(); ++i) {
+                std::cout << i + 1 << ". " << children[i].value.action << "\n";
+            }
         }
+        return children;
+    };
 
-        std::cout << "Choose your next action:\n";
-        for (size_t i = 0; i < childrenIDs.size(); ++i) {
-            std::cout << i + 1 << ". " << storyTree[childrenIDs[i]].action << "\n";
+    // Main Game loop
+    while (true) {
+        auto children = showTurn();
+        if (children.empty()) {
+            std::cout << "End of story reached. Thanks for playing!\n";
+            break;
         }
 
         // Gets the user choice, and then the user picks a choice
         int choice;
-        std::cout << "Enter your choice (1-" << childrenIDs.size() << "): ";
+        std::cout << "Enter your choice (1-" << children.size() << "): ";
         std::cin >> choice;
 
         // Validates user input
-        if (choice < 1 || choice > static_cast<int>(childrenIDs.size())) {
-            std::cout << "Invalid choice. Please enter a number between 1 and " << childrenIDs.size() << ".\n";
+        if (choice < 1 || choice > static_cast<int>(children.size())) {
+            std::cout << "Invalid choice. Please enter a number between 1 and " << children.size() << ".\n";
             continue;
         }
 
         // updates the node based on what the user input
-        currentNodeID = childrenIDs[choice - 1];
+        currentNodeID = children[choice - 1].id;
     }
 
     return 0;
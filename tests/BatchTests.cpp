@@ -0,0 +1,142 @@
+/**
+ * Tests for Tree::batch: a committed batch must leave the tree, its IDs, its
+ * journal and its path statistics exactly as the equivalent appendNode and
+ * removeNode calls would, and a failed batch must leave it untouched.
+ */
+
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "TestSupport.h"
+#include "Tree.h"
+
+// IDs of the live nodes, in pre-order.
+static std::vector<int> liveIDs(const Tree<int>& tree) {
+    std::vector<int> ids;
+    for (const auto& node : tree.preOrder()) {
+        ids.push_back(node.id);
+    }
+    return ids;
+}
+
+// Compares path statistics node by node in pre-order, so the trees' IDs may differ.
+static void checkSameStats(const Tree<int>& tree, const Tree<int>& expected) {
+    std::vector<int> ids = liveIDs(tree), expectedIDs = liveIDs(expected);
+    CHECK(ids.size() == expectedIDs.size());
+    for (size_t i = 0; i < ids.size() && i < expectedIDs.size(); ++i) {
+        const auto& stats = tree.pathStats(ids[i]);
+        const auto& want = expected.pathStats(expectedIDs[i]);
+        CHECK(stats.depth == want.depth);
+        CHECK(stats.endingCount == want.endingCount);
+        CHECK(stats.minTurnsToEnding == want.minTurnsToEnding);
+        CHECK(stats.maxTurnsToEnding == want.maxTurnsToEnding);
+    }
+}
+
+// Random batches checked against the same edits made one call at a time. A
+// tracked tree replays a batch as single edits, so batches are run both with
+// and without tracking.
+static void testMatchesSingleEdits() {
+    Tree<int> batched(0), tracked(0), single(0);
+    for (Tree<int>* tree : {&batched, &tracked, &single}) {
+        tree->annotatePaths(true);
+    }
+    tracked.trackChanges(true);
+
+    std::mt19937 random(7);
+    for (int round = 0; round < 50; ++round) {
+        // half the appends go under nodes queued earlier in the same batch
+        std::vector<int> ids = liveIDs(single);
+        std::vector<std::pair<int, int>> appends; // parent, value
+        std::vector<int> appended;
+        for (int i = 0; i < 40; ++i) {
+            int parent = !appended.empty() && random() % 2 ? appended[random() % appended.size()]
+                                                           : ids[random() % ids.size()];
+            appends.emplace_back(parent, round * 100 + i);
+            appended.push_back(single.appendNode(parent, round * 100 + i));
+        }
+        std::vector<int> removals;
+        for (int i = 0; i < 5; ++i) {
+            int node = random() % 3 ? ids[random() % ids.size()] : appended[random() % appended.size()];
+            if (node != single.getRootID()) {
+                removals.push_back(node);
+            }
+        }
+        // removals land after every append; removing inside an already removed subtree is a no-op
+        for (int node : removals) {
+            std::vector<int> live = liveIDs(single);
+            if (std::find(live.begin(), live.end(), node) != live.end()) {
+                single.removeNode(node);
+            }
+        }
+
+        for (Tree<int>* tree : {&batched, &tracked}) {
+            tree->batch([&](auto& batch) {
+                batch.reserve(appends.size());
+                for (size_t i = 0; i < appends.size(); ++i) {
+                    CHECK(batch.append(appends[i].first, appends[i].second) == appended[i]);
+                }
+                for (int node : removals) {
+                    batch.remove(node);
+                }
+            });
+            CHECK(tree->serialize() == single.serialize());
+            CHECK(liveIDs(*tree) == liveIDs(single));
+        }
+    }
+    checkSameStats(batched, single);
+    checkSameStats(tracked, single);
+
+    Tree<int> recomputed = Tree<int>::deserializeStrict(batched.serialize());
+    recomputed.annotatePaths(true);
+    checkSameStats(batched, recomputed);
+
+    Tree<int> replayed(0);
+    replayed.applyJournal(tracked.pendingChanges());
+    CHECK(replayed.serialize() == tracked.serialize());
+}
+
+static void testFailedBatches() {
+    Tree<int> tree(0);
+    int child = tree.appendNode(0, 1);
+    tree.trackChanges(true);
+    std::string before = tree.serialize();
+
+    CHECK_THROWS(std::runtime_error, tree.batch([&](auto& batch) {
+        batch.append(child, 2);
+        batch.remove(child);
+        throw std::runtime_error("abandoned");
+    }));
+    CHECK_THROWS(std::invalid_argument, tree.batch([&](auto& batch) {
+        batch.append(0, 2);
+        batch.append(99, 3);
+    }));
+    CHECK_THROWS(std::invalid_argument, tree.batch([&](auto& batch) { batch.remove(0); }));
+    CHECK_THROWS(std::invalid_argument, tree.batch([&](auto& batch) { batch.remove(42); }));
+    CHECK(tree.serialize() == before);
+    CHECK(tree.pendingChanges().empty());
+    // the failed batches handed out no IDs
+    CHECK(tree.appendNode(0, 5) == child + 1);
+    before = tree.serialize();
+
+    // the tree itself is off limits while a batch is being built
+    CHECK_THROWS(std::logic_error, tree.batch([&](auto&) { tree.appendNode(0, 3); }));
+    CHECK_THROWS(std::logic_error, tree.batch([&](auto&) { tree.removeNode(child); }));
+    CHECK_THROWS(std::logic_error, tree.batch([&](auto&) { tree.moveSubtree(child, 0); }));
+    CHECK_THROWS(std::logic_error, tree.batch([&](auto&) { tree.batch([](auto&) {}); }));
+    CHECK(tree.serialize() == before);
+
+    // the guard is lifted again afterwards
+    tree.batch([&](auto& batch) { batch.append(child, 6); });
+    CHECK(tree.childCount(child) == 1);
+}
+
+int main() {
+    testMatchesSingleEdits();
+    testFailedBatches();
+    return testResult("BatchTests");
+}
\ No newline at end of file
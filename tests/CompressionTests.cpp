@@ -0,0 +1,172 @@
+/**
+ * Tests for the block-compressed storyline container: the LZ block coder,
+ * round trips through the decoder and LazyTree at several block sizes, version 1
+ * files, and rejection of damaged or truncated containers.
+ */
+
+#include <filesystem>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+#include "BlockCompression.h"
+#include "FrozenTree.h"
+#include "LazyTree.h"
+#include "StoryNode.h"
+#include "TestSupport.h"
+#include "Tree.h"
+#include "utils.h"
+
+// Encodes a tree as version 1 wrote it: one child count per node and all values in a single block.
+static std::string encodeVersion1(const Tree<StoryNode>& tree) {
+    FrozenTree<StoryNode> frozen = tree.freeze();
+    std::string structure, values;
+    for (size_t id = 0; id < frozen.size(); ++id) {
+        size_t start = values.size();
+        encodeBinary(values, frozen[id]);
+        writeVarint(structure, frozen.childCount(id));
+        writeVarint(structure, values.size() - start);
+    }
+    std::string out(COMPRESSED_TREE_MAGIC, COMPRESSED_TREE_MAGIC_SIZE);
+    out.push_back(static_cast<char>(COMPRESSED_TREE_VERSION_UNCHAINED));
+    out.push_back(0);
+    writeVarint(out, frozen.size());
+    writeVarint(out, 1);
+    std::string packedStructure, packedValues;
+    compressBlock(packedStructure, structure);
+    compressBlock(packedValues, values);
+    writeCompressedBlockHeader(out, CompressedBlock{0, structure.size(), packedStructure.size(), fnv1a64(structure), 0}, false);
+    out += packedStructure;
+    writeCompressedBlockHeader(out, CompressedBlock{0, values.size(), packedValues.size(), fnv1a64(values), 0}, true);
+    out += packedValues;
+    return out;
+}
+
+static void checkLazy(const LazyTree<StoryNode>& lazy, const Tree<StoryNode>& tree) {
+    FrozenTree<StoryNode> frozen = tree.freeze();
+    CHECK(lazy.size() == frozen.size());
+    for (size_t id = 0; id < frozen.size(); ++id) {
+        int node = static_cast<int>(id);
+        CHECK(lazy[node] == frozen[id]);
+        CHECK(lazy.childCount(node) == frozen.childCount(id));
+        CHECK(lazy.subtreeSize(node) == frozen.subtreeSize(id));
+    }
+}
+
+static void testBlockCoder() {
+    std::mt19937 random(3);
+    const std::string alphabet = "action: \"outcome\"";
+    for (int trial = 0; trial < 300; ++trial) {
+        std::string raw(random() % 5000, '\0');
+        for (size_t i = 0; i < raw.size(); ++i) {
+            // random bytes, two-letter runs, and text like a story's
+            raw[i] = trial % 3 == 0 ? static_cast<char>(random())
+                   : trial % 3 == 1 ? "ab"[random() % 2]
+                                    : alphabet[(random() % 3 + i % 7) % alphabet.size()];
+        }
+        std::string compressed, restored;
+        compressBlock(compressed, raw);
+        decompressBlock(compressed, raw.size(), restored);
+        CHECK(restored == raw);
+    }
+
+    std::string repeated(100000, 'z'), compressed, restored;
+    compressBlock(compressed, repeated);
+    CHECK(compressed.size() < repeated.size() / 100);
+    decompressBlock(compressed, repeated.size(), restored);
+    CHECK(restored == repeated);
+    // a recorded size the coder couldn't have produced is rejected before allocating
+    CHECK_THROWS(std::invalid_argument, decompressBlock(compressed, repeated.size() * LZ_MAX_EXPANSION * 2, restored));
+    CHECK_THROWS(std::invalid_argument, decompressBlock(compressed, repeated.size() - 1, restored));
+}
+
+static void testRoundTrips() {
+    Tree<StoryNode> story = loadStoryline("varian_wrynn.txt");
+    std::string text = story.serialize();
+    for (size_t blockSize : {size_t(0), size_t(100), size_t(4096), COMPRESSED_TREE_BLOCK_SIZE, size_t(1) << 30}) {
+        std::string compressed = story.serializeCompressed(blockSize);
+        CHECK(isCompressedTree(compressed));
+        CHECK(static_cast<std::uint8_t>(compressed[COMPRESSED_TREE_MAGIC_SIZE]) == COMPRESSED_TREE_VERSION);
+        CHECK(Tree<StoryNode>::deserializeCompressedStrict(compressed).serialize() == text);
+        LazyTree<StoryNode> lazy(compressed, 4);
+        checkLazy(lazy, story);
+        CHECK(lazy.extractSubtree(3).serialize() == LazyTree<StoryNode>(text, 4).extractSubtree(3).serialize());
+    }
+    CHECK(story.serializeCompressed().size() < story.serializeBinary().size());
+
+    std::string buffer = "kept";
+    story.serializeCompressed(buffer);
+    CHECK(buffer == "kept" + story.serializeCompressed());
+
+    std::string old = encodeVersion1(story);
+    CHECK(Tree<StoryNode>::deserializeCompressedStrict(old).serialize() == text);
+    checkLazy(LazyTree<StoryNode>(old, 4), story);
+
+    Tree<StoryNode> empty;
+    CHECK(Tree<StoryNode>::deserializeCompressedStrict(empty.serializeCompressed()).getRootID() == -1);
+    CHECK(LazyTree<StoryNode>(empty.serializeCompressed(), 4).size() == 0);
+}
+
+// Flips a byte inside every value block in turn; both readers must notice.
+static void testCorruptBlocks() {
+    Tree<StoryNode> story = loadStoryline("varian_wrynn.txt");
+    std::string compressed = story.serializeCompressed(2048);
+    CompressedTreeLayout layout = readCompressedLayout(compressed);
+    CHECK(layout.blocks.size() > 10);
+    for (const CompressedBlock& block : layout.blocks) {
+        std::string damaged = compressed;
+        damaged[block.offset + block.compressedSize / 2] ^= 0x5a;
+        CHECK_THROWS(std::invalid_argument, Tree<StoryNode>::deserializeCompressedStrict(damaged));
+        LazyTree<StoryNode> lazy(damaged, 4);
+        CHECK_THROWS(std::invalid_argument, lazy[static_cast<int>(block.firstNode)]);
+    }
+
+    // damage to the header or structure block fails up front
+    for (size_t position : {size_t(3), size_t(COMPRESSED_TREE_HEADER_SIZE + 4)}) {
+        std::string damaged = compressed;
+        damaged[position] ^= 0x5a;
+        CHECK_THROWS(std::invalid_argument, Tree<StoryNode>::deserializeCompressedStrict(damaged));
+        CHECK_THROWS(std::invalid_argument, LazyTree<StoryNode>(damaged, 4));
+    }
+    // the table ends with the last block's checksum, which LazyTree checks when it reads that block
+    std::string damagedTable = compressed;
+    damagedTable[layout.blocks.front().offset - 1] ^= 0x5a;
+    CHECK_THROWS(std::invalid_argument, Tree<StoryNode>::deserializeCompressedStrict(damagedTable));
+    LazyTree<StoryNode> lazyTable(damagedTable, 4);
+    CHECK(lazyTable[0] == story[0]);
+    CHECK_THROWS(std::invalid_argument, lazyTable[static_cast<int>(layout.blocks.back().firstNode)]);
+
+    for (size_t length : {size_t(0), size_t(5), compressed.size() / 2, compressed.size() - 1}) {
+        CHECK_THROWS(std::invalid_argument, Tree<StoryNode>::deserializeCompressedStrict(compressed.substr(0, length)));
+    }
+
+    std::string flagged = compressed;
+    flagged[COMPRESSED_TREE_MAGIC_SIZE + 1] = 0x01;
+    CHECK_THROWS(std::invalid_argument, Tree<StoryNode>::deserializeCompressedStrict(flagged));
+    CHECK_THROWS(std::invalid_argument, LazyTree<StoryNode>(flagged, 4));
+
+    std::string future = compressed;
+    future[COMPRESSED_TREE_MAGIC_SIZE] = static_cast<char>(COMPRESSED_TREE_VERSION + 1);
+    CHECK_THROWS(std::invalid_argument, Tree<StoryNode>::deserializeCompressedStrict(future));
+}
+
+static void testStorylineFiles() {
+    Tree<StoryNode> story = loadStoryline("varian_wrynn.txt");
+    std::string text = story.serialize();
+    std::filesystem::path file = std::filesystem::temp_directory_path() / "CompressionTests.trz";
+    std::string buffer;
+    CHECK(static_cast<bool>(trySaveStoryline(story, file, StoryFormat::Compressed, buffer)));
+    CHECK(loadStoryline(file).serialize() == text);
+    CHECK(tryLoadStoryline(file).value.serialize() == text);
+    CHECK(loadStorylineParallel(file).serialize() == text);
+    CHECK(openStorylineLazy(file)[7] == story[7]);
+    std::filesystem::remove(file);
+}
+
+int main() {
+    testBlockCoder();
+    testRoundTrips();
+    testCorruptBlocks();
+    testStorylineFiles();
+    return testResult("CompressionTests");
+}
\ No newline at end of file
@@ -0,0 +1,211 @@
+/**
+ * Tests for the text and binary storyline formats: round trips through every
+ * writer, the "[X*n]" runs and binary chain records, the index footer read by
+ * LazyTree, and rejection of malformed or unknown input.
+ */
+
+#include <filesystem>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "ArenaTree.h"
+#include "BinaryCodec.h"
+#include "FrozenTree.h"
+#include "LazyTree.h"
+#include "StoryNode.h"
+#include "TestSupport.h"
+#include "Tree.h"
+#include "utils.h"
+
+static void encode(std::string& out, const StoryNode& value) {
+    encodeBinary(out, value);
+}
+
+static void encode(std::string& out, int value) {
+    writeLengthPrefixed(out, std::to_string(value));
+}
+
+// Encodes a tree as version 1 wrote it, one child count per record, so old files keep loading.
+template <typename T>
+static std::string encodeVersion1(const Tree<T>& tree, bool withIndex) {
+    std::string out(BINARY_TREE_MAGIC, BINARY_TREE_MAGIC_SIZE);
+    out.push_back(static_cast<char>(BINARY_TREE_VERSION_UNCHAINED));
+    out.push_back(static_cast<char>(withIndex ? BINARY_TREE_FLAG_INDEX : 0));
+    FrozenTree<T> frozen = tree.freeze();
+    writeVarint(out, frozen.size());
+    std::string index;
+    for (size_t id = 0; id < frozen.size(); ++id) {
+        writeBinaryIndexEntry(index, BinaryIndexEntry{out.size(), static_cast<std::uint32_t>(frozen.childCount(id)),
+                                                      static_cast<std::uint32_t>(frozen.subtreeSize(id))});
+        writeVarint(out, frozen.childCount(id));
+        encode(out, frozen[id]);
+    }
+    if (withIndex) {
+        std::uint64_t indexOffset = out.size();
+        out += index;
+        writeBinaryIndexTrailer(out, indexOffset, fnv1a64(index));
+    }
+    return out;
+}
+
+// A chain of `length` nodes with a branch at each end, the shape chain records are for.
+static Tree<int> chainTree(int length) {
+    Tree<int> tree(0);
+    int last = 0;
+    for (int i = 1; i < length; ++i) {
+        last = tree.appendNode(last, i);
+    }
+    tree.appendNode(0, -1);
+    tree.appendNode(last, -2);
+    return tree;
+}
+
+// Checks every node of a LazyTree against the frozen form of the tree it was written from.
+template <typename T>
+static void checkLazy(const LazyTree<T>& lazy, const Tree<T>& tree) {
+    FrozenTree<T> frozen = tree.freeze();
+    CHECK(lazy.size() == frozen.size());
+    for (size_t id = 0; id < frozen.size(); ++id) {
+        int node = static_cast<int>(id);
+        CHECK(lazy[node] == frozen[id]);
+        CHECK(lazy.childCount(node) == frozen.childCount(id));
+        CHECK(lazy.subtreeSize(node) == frozen.subtreeSize(id));
+    }
+}
+
+static void testTextRuns() {
+    Tree<int> pair(1);
+    pair.appendNode(0, 2);
+    CHECK(pair.serialize() == "[0]: 1\n[1]: 2\n[X]\n[X]\n");
+    CHECK(pair.serialize(true) == "[0]: 1\n[1]: 2\n[X*2]\n");
+    CHECK(Tree<int>::deserializeStrict("[0]: 1\n[1]: 2\n[X*2]\n").serialize() == pair.serialize());
+
+    Tree<StoryNode> story = loadStoryline("varian_wrynn.txt");
+    std::string plain = story.serialize();
+    std::string runs = story.serialize(true);
+    CHECK(plain.find("[X*") == std::string::npos);
+    CHECK(runs.find("[X*") != std::string::npos);
+    CHECK(runs.size() < plain.size());
+    CHECK(Tree<StoryNode>::deserializeStrict(runs).serialize() == plain);
+    CHECK(Tree<StoryNode>::deserializeParallel(runs, 3).serialize() == plain);
+
+    std::ostringstream os;
+    story.serialize(os, true);
+    CHECK(os.str() == runs);
+    std::string buffer = "kept";
+    story.serialize(buffer);
+    CHECK(buffer == "kept" + plain);
+
+    ArenaTree<StoryNode> arena = ArenaTree<StoryNode>::deserialize(runs);
+    CHECK(arena.serialize() == plain);
+    CHECK(arena.serialize(true) == runs);
+
+    LazyTree<StoryNode> lazy(runs, 16);
+    checkLazy(lazy, story);
+}
+
+static void testMalformedText() {
+    CHECK_THROWS(std::invalid_argument, Tree<int>::deserializeStrict("[0]: 1\n[X*3]\n"));
+    CHECK_THROWS(std::invalid_argument, Tree<int>::deserializeStrict("[0]: 1\n[X*0]\n"));
+    CHECK_THROWS(std::invalid_argument, Tree<int>::deserializeStrict("[0]: 1\n[X*2a]\n"));
+    CHECK_THROWS(std::invalid_argument, Tree<int>::deserializeStrict("[0]: 1\n[X*99999999999999999999]\n"));
+    CHECK_THROWS(std::invalid_argument, Tree<int>::deserializeStrict("[0]: 1\n[1]: 2\n[X]\n"));
+}
+
+template <typename T>
+static void checkBinaryRoundTrip(const Tree<T>& tree) {
+    std::string text = tree.serialize();
+    for (bool withIndex : {false, true}) {
+        std::string binary = tree.serializeBinary(withIndex);
+        CHECK(isBinaryTree(binary));
+        CHECK(static_cast<std::uint8_t>(binary[BINARY_TREE_MAGIC_SIZE]) == BINARY_TREE_VERSION);
+        CHECK(binaryTreeFlags(binary) == (withIndex ? BINARY_TREE_FLAG_INDEX : 0));
+        CHECK(Tree<T>::deserializeBinaryStrict(binary).serialize() == text);
+
+        std::ostringstream os;
+        tree.serializeBinary(os, withIndex);
+        CHECK(os.str() == binary);
+        std::string buffer = "kept";
+        tree.serializeBinary(buffer, withIndex);
+        CHECK(buffer == "kept" + binary);
+
+        LazyTree<T> lazy(binary, 4);
+        CHECK(lazy.hasPersistedIndex() == withIndex);
+        checkLazy(lazy, tree);
+
+        std::string old = encodeVersion1(tree, withIndex);
+        CHECK(Tree<T>::deserializeBinaryStrict(old).serialize() == text);
+        LazyTree<T> oldLazy(old, 4);
+        checkLazy(oldLazy, tree);
+    }
+}
+
+static void testBinaryRoundTrips() {
+    checkBinaryRoundTrip(loadStoryline("varian_wrynn.txt"));
+    checkBinaryRoundTrip(chainTree(5000));
+    checkBinaryRoundTrip(Tree<int>(7));
+    Tree<int> pair(1);
+    pair.appendNode(0, 2);
+    checkBinaryRoundTrip(pair);
+
+    Tree<int> empty;
+    CHECK(Tree<int>::deserializeBinaryStrict(empty.serializeBinary(true)).getRootID() == -1);
+
+    // a chain shares one record header, so it is smaller than version 1's header per node
+    Tree<int> chain = chainTree(5000);
+    CHECK(chain.serializeBinary().size() < encodeVersion1(chain, false).size());
+}
+
+static void testMalformedBinary() {
+    Tree<int> chain = chainTree(1000);
+    std::string binary = chain.serializeBinary(true);
+
+    std::string records = chain.serializeBinary();
+    std::string truncated = records.substr(0, records.size() / 2);
+    CHECK_THROWS(std::invalid_argument, Tree<int>::deserializeBinaryStrict(truncated));
+    CHECK_THROWS(std::invalid_argument, LazyTree<int>(truncated, 1));
+    // the decoders don't need the index, but LazyTree does
+    CHECK_THROWS(std::invalid_argument, LazyTree<int>(binary.substr(0, binary.size() - 1), 1));
+
+    // a zero-length chain header where the root's record starts
+    std::string emptyChain = records;
+    std::string nodeCount;
+    writeVarint(nodeCount, 1002);
+    emptyChain[BINARY_TREE_HEADER_SIZE + nodeCount.size()] = 1;
+    CHECK_THROWS(std::invalid_argument, Tree<int>::deserializeBinaryStrict(emptyChain));
+
+    for (std::uint8_t flag : {std::uint8_t(0x04), std::uint8_t(0x80)}) {
+        std::string unknown = binary;
+        unknown[BINARY_TREE_MAGIC_SIZE + 1] = static_cast<char>(unknown[BINARY_TREE_MAGIC_SIZE + 1] | flag);
+        CHECK_THROWS(std::invalid_argument, Tree<int>::deserializeBinaryStrict(unknown));
+        CHECK_THROWS(std::invalid_argument, LazyTree<int>(unknown, 1));
+    }
+
+    std::string future = binary;
+    future[BINARY_TREE_MAGIC_SIZE] = static_cast<char>(BINARY_TREE_VERSION + 1);
+    CHECK_THROWS(std::invalid_argument, Tree<int>::deserializeBinaryStrict(future));
+    CHECK_THROWS(std::invalid_argument, LazyTree<int>(future, 1));
+
+    // a damaged index fails its checksum
+    std::string badIndex = binary;
+    badIndex[badIndex.size() - BINARY_INDEX_TRAILER_SIZE - 1] ^= 0x5a;
+    CHECK_THROWS(std::invalid_argument, LazyTree<int>(badIndex, 1));
+}
+
+static void testInterned() {
+    Tree<StoryNode> story = loadStoryline("varian_wrynn.txt");
+    std::filesystem::path file = std::filesystem::temp_directory_path() / "FormatTests.trb";
+    saveStorylineInterned(internStoryline(story), file);
+    CHECK(loadStorylineInterned(file).serialize() == story.serialize());
+    std::filesystem::remove(file);
+}
+
+int main() {
+    testTextRuns();
+    testMalformedText();
+    testBinaryRoundTrips();
+    testMalformedBinary();
+    testInterned();
+    return testResult("FormatTests");
+}
\ No newline at end of file
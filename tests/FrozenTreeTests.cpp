@@ -0,0 +1,159 @@
+/**
+ * Tests for FrozenTree: every node's value, parent, children and subtree size
+ * must agree with the Tree it was frozen from, for random shapes, long chains
+ * and a real story, and mapUnchangedNodes must follow edits between snapshots.
+ */
+
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "FrozenTree.h"
+#include "StoryNode.h"
+#include "TestSupport.h"
+#include "Tree.h"
+#include "utils.h"
+
+// Checks a snapshot against the tree's own pre-order walk and child lists.
+template <typename T>
+static void checkSnapshot(const Tree<T>& tree) {
+    FrozenTree<T> frozen = tree.freeze();
+    std::vector<int> preOrder;
+    for (const auto& node : tree.preOrder()) {
+        preOrder.push_back(node.id);
+    }
+    CHECK(frozen.size() == preOrder.size());
+    CHECK(frozen.getRootID() == (preOrder.empty() ? -1 : 0));
+    if (preOrder.empty()) {
+        return;
+    }
+
+    // pre-order position of each tree ID, and subtree sizes summed from the leaves up
+    std::vector<int> position(static_cast<size_t>(*std::max_element(preOrder.begin(), preOrder.end())) + 1, -1);
+    for (size_t i = 0; i < preOrder.size(); ++i) {
+        position[preOrder[i]] = static_cast<int>(i);
+    }
+    std::vector<size_t> subtreeSizes(preOrder.size(), 1);
+    for (size_t i = preOrder.size(); i-- > 0;) {
+        for (int child : tree.getChildrenIDs(preOrder[i])) {
+            subtreeSizes[i] += subtreeSizes[position[child]];
+        }
+    }
+
+    CHECK(frozen.getParentID(0) == -1);
+    for (size_t i = 0; i < preOrder.size(); ++i) {
+        int id = static_cast<int>(i);
+        std::vector<int> children = tree.getChildrenIDs(preOrder[i]);
+        CHECK(frozen[id] == tree[preOrder[i]]);
+        CHECK(frozen.childCount(id) == children.size());
+        CHECK(frozen.subtreeSize(id) == subtreeSizes[i]);
+
+        std::vector<int> frozenChildren = frozen.getChildrenIDs(id);
+        std::vector<int> ranged;
+        for (const auto& child : frozen.children(id)) {
+            ranged.push_back(child.id);
+            CHECK(child.value == frozen[child.id]);
+        }
+        CHECK(frozenChildren == ranged);
+        CHECK(frozenChildren.size() == children.size());
+        for (size_t k = 0; k < children.size() && k < frozenChildren.size(); ++k) {
+            CHECK(frozenChildren[k] == position[children[k]]);
+            CHECK(frozen.getParentID(frozenChildren[k]) == id);
+        }
+    }
+
+    CHECK(frozen.thaw().serialize() == tree.serialize());
+    CHECK(tree.freeze().thaw().serialize() == tree.serialize());
+}
+
+static void testRandomShapes() {
+    std::mt19937 random(5);
+    for (int trial = 0; trial < 300; ++trial) {
+        Tree<int> tree(0);
+        std::vector<int> ids{0};
+        int nodeCount = 1 + static_cast<int>(random() % 400);
+        for (int i = 1; i < nodeCount; ++i) {
+            // mostly extend the last node, so the shapes have long chains
+            int parent = random() % 3 == 0 ? ids[random() % ids.size()] : ids.back();
+            ids.push_back(tree.appendNode(parent, i));
+        }
+        // removed nodes leave gaps in the tree's IDs, which the snapshot closes up
+        if (trial % 5 == 0 && ids.size() > 3) {
+            tree.removeNode(ids[ids.size() / 2]);
+        }
+        checkSnapshot(tree);
+    }
+}
+
+static void testShapes() {
+    checkSnapshot(Tree<int>());
+    checkSnapshot(Tree<int>(1));
+
+    Tree<int> chain(0);
+    int last = 0;
+    for (int i = 1; i < 20000; ++i) {
+        last = chain.appendNode(last, i);
+    }
+    chain.appendNode(3, -1);
+    checkSnapshot(chain);
+
+    Tree<int> wide(0);
+    for (int i = 1; i < 5000; ++i) {
+        wide.appendNode(0, i);
+    }
+    checkSnapshot(wide);
+
+    checkSnapshot(loadStoryline("varian_wrynn.txt"));
+
+    FrozenTree<int> empty;
+    CHECK(empty.size() == 0);
+    CHECK_THROWS(std::invalid_argument, empty.getParentID(0));
+    FrozenTree<int> single = Tree<int>(1).freeze();
+    CHECK_THROWS(std::invalid_argument, single.getValue(1));
+    CHECK_THROWS(std::invalid_argument, single.childCount(-1));
+    CHECK_THROWS(std::invalid_argument, single.subtreeSize(1));
+}
+
+static void testUnchangedNodes() {
+    Tree<StoryNode> story = loadStoryline("varian_wrynn.txt");
+    FrozenTree<StoryNode> before = story.freeze();
+    CHECK(mapUnchangedNodes(before, before) == [&]() {
+        std::vector<int> identity(before.size());
+        for (size_t id = 0; id < identity.size(); ++id) {
+            identity[id] = static_cast<int>(id);
+        }
+        return identity;
+    }());
+
+    // drop the root's first branch and add a new one at the end
+    int root = story.getRootID();
+    int firstBranch = story.getChildrenIDs(root).front();
+    size_t removedCount = before.subtreeSize(1);
+    story.removeNode(firstBranch);
+    story.appendNode(root, StoryNode{"new", "branch"});
+    FrozenTree<StoryNode> after = story.freeze();
+
+    std::vector<int> mapping = mapUnchangedNodes(before, after);
+    CHECK(mapping.size() == before.size());
+    CHECK(mapping[0] == 0);
+    for (size_t id = 1; id <= removedCount; ++id) {
+        CHECK(mapping[id] == -1);
+    }
+    for (size_t id = removedCount + 1; id < before.size(); ++id) {
+        CHECK(mapping[id] == static_cast<int>(id - removedCount));
+        CHECK(after[mapping[id]] == before[static_cast<int>(id)]);
+    }
+
+    // a changed root shares nothing
+    Tree<StoryNode> other(StoryNode{"another", "story"});
+    CHECK(mapUnchangedNodes(before, other.freeze()) == std::vector<int>(before.size(), -1));
+}
+
+int main() {
+    testRandomShapes();
+    testShapes();
+    testUnchangedNodes();
+    return testResult("FrozenTreeTests");
+}
\ No newline at end of file
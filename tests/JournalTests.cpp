@@ -0,0 +1,159 @@
+/**
+ * Tests for change tracking and journal replay, and for the incremental saves
+ * built on them.
+ */
+
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "StoryNode.h"
+#include "TestSupport.h"
+#include "Tree.h"
+#include "utils.h"
+
+static void testJournalLines() {
+    Tree<int> tree(0);
+    tree.appendNode(0, 1);
+    int second = tree.appendNode(0, 2);
+    Tree<int> saved = Tree<int>::deserializeStrict(tree.serialize());
+
+    tree.trackChanges(true);
+    CHECK(tree.isTrackingChanges());
+    int moved = tree.appendNode(second, 3);
+    tree.moveSubtree(moved, 0);
+    tree.removeNode(1);
+    Tree<int> graft(9);
+    graft.appendNode(0, 10);
+    tree.graftSubtree(second, std::move(graft));
+    CHECK(tree.pendingChanges() == "+[/1]: 3\n>[/1/0]: /\n-[/0]\n+[/0]: 9\n+[/0/0]: 10\n");
+
+    saved.applyJournal(tree.pendingChanges());
+    CHECK(saved.serialize() == tree.serialize());
+    // replayed edits are not recorded again
+    CHECK(saved.pendingChanges().empty());
+
+    tree.clearChanges();
+    CHECK(tree.pendingChanges().empty());
+    tree.trackChanges(false);
+    tree.appendNode(0, 4);
+    CHECK(tree.pendingChanges().empty());
+
+    Tree<int> fresh;
+    fresh.trackChanges(true);
+    fresh.setRoot(5);
+    Tree<int> replayed;
+    replayed.applyJournal(fresh.pendingChanges());
+    CHECK(replayed.serialize() == fresh.serialize());
+}
+
+// Random edits on a story, replayed onto a copy of the tree as it was before them.
+static void testRandomReplay() {
+    Tree<StoryNode> story = loadStoryline("varian_wrynn.txt");
+    Tree<StoryNode> saved = Tree<StoryNode>::deserializeStrict(story.serialize());
+    story.trackChanges(true);
+    std::mt19937 random(11);
+    for (int edit = 0; edit < 500; ++edit) {
+        std::vector<int> ids;
+        for (const auto& node : story.preOrder()) {
+            ids.push_back(node.id);
+        }
+        int target = ids[random() % ids.size()];
+        switch (random() % 3) {
+        case 0:
+            story.appendNode(target, StoryNode{"edit " + std::to_string(edit), "outcome"});
+            break;
+        case 1:
+            if (target != story.getRootID()) {
+                story.removeNode(target);
+            }
+            break;
+        default:
+            // moves of the root or into a node's own subtree are rejected, and leave no journal line
+            int destination = ids[random() % ids.size()];
+            try {
+                story.moveSubtree(target, destination);
+            } catch (const std::invalid_argument&) {
+            }
+        }
+    }
+    saved.applyJournal(story.pendingChanges());
+    CHECK(saved.serialize() == story.serialize());
+}
+
+static void testMalformedJournal() {
+    Tree<int> tree(0);
+    tree.appendNode(0, 1);
+    std::string before = tree.serialize();
+    CHECK_THROWS(std::invalid_argument, tree.applyJournal("?[/]: 1\n"));
+    CHECK_THROWS(std::invalid_argument, tree.applyJournal("+[/7]: 1\n"));
+    CHECK_THROWS(std::invalid_argument, tree.applyJournal("+[/]: not a number\n"));
+    CHECK_THROWS(std::invalid_argument, tree.applyJournal("-[/0] trailing\n"));
+    CHECK_THROWS(std::invalid_argument, tree.applyJournal("=[/]: 3\n"));
+    CHECK(tree.serialize() == before);
+
+    // the edits before a bad line stay applied, and tracking is left as it was
+    tree.trackChanges(true);
+    CHECK_THROWS(std::invalid_argument, tree.applyJournal("+[/]: 2\n-[/5]\n"));
+    CHECK(tree.childCount(0) == 2);
+    CHECK(tree.isTrackingChanges());
+    CHECK(tree.pendingChanges().empty());
+
+    CHECK_THROWS(std::logic_error, tree.batch([&](auto&) { tree.applyJournal("+[/]: 2\n"); }));
+}
+
+static void testIncrementalSaves() {
+    std::filesystem::path file = std::filesystem::temp_directory_path() / "JournalTests.txt";
+    std::filesystem::path journal = file;
+    journal += ".journal";
+    std::filesystem::remove(file);
+    std::filesystem::remove(journal);
+
+    Tree<StoryNode> story = loadStoryline("varian_wrynn.txt");
+    // no snapshot yet, so the first save writes one
+    saveStorylineIncremental(story, file);
+    CHECK(std::filesystem::exists(file));
+    CHECK(!std::filesystem::exists(journal));
+    CHECK(story.isTrackingChanges());
+    std::uintmax_t snapshotSize = std::filesystem::file_size(file);
+
+    story.appendNode(story.getRootID(), StoryNode{"journaled", "edit"});
+    story.removeNode(story.getChildrenIDs(story.getRootID()).front());
+    saveStorylineIncremental(story, file);
+    CHECK(std::filesystem::file_size(file) == snapshotSize);
+    CHECK(std::filesystem::exists(journal));
+    CHECK(story.pendingChanges().empty());
+    CHECK(loadStoryline(file).serialize() == story.serialize());
+    CHECK(tryLoadStoryline(file).value.serialize() == story.serialize());
+    CHECK(loadStorylineParallel(file).serialize() == story.serialize());
+
+    // past the threshold the journal is folded into a new snapshot
+    story.appendNode(story.getRootID(), StoryNode{"compacted", "edit"});
+    saveStorylineIncremental(story, file, 0);
+    CHECK(!std::filesystem::exists(journal));
+    CHECK(loadStoryline(file).serialize() == story.serialize());
+
+    // a journal that fails to replay fails the strict load without returning part of it
+    {
+        std::ofstream corrupt(journal, std::ios::binary);
+        corrupt << "-[/0]\n-[/99/99]\n";
+    }
+    StoryResult<Tree<StoryNode>> result = tryLoadStoryline(file);
+    CHECK(!result);
+    CHECK(result.status.error == StoryError::Malformed);
+    CHECK(result.value.getRootID() == -1);
+
+    std::filesystem::remove(file);
+    std::filesystem::remove(journal);
+}
+
+int main() {
+    testJournalLines();
+    testRandomReplay();
+    testMalformedJournal();
+    testIncrementalSaves();
+    return testResult("JournalTests");
+}
\ No newline at end of file
@@ -0,0 +1,157 @@
+/**
+ * Tests for the vectorized scanning helpers. Each is checked against a plain
+ * byte-at-a-time reference, at every alignment and length around the block
+ * size, so the SSE2, AVX2 or NEON path the build picked must agree with the
+ * scalar one. Building with -mavx2 tests the AVX2 path, and with -U__SSE2__
+ * the scalar fallback.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "LineScanner.h"
+#include "TestSupport.h"
+
+static const char* referenceFind(const char* begin, const char* end, char first, char second) {
+    for (; begin != end; ++begin) {
+        if (*begin == first || *begin == second) {
+            return begin;
+        }
+    }
+    return end;
+}
+
+// Splits at every '\n'; a last line without one still counts unless it is empty.
+static std::vector<std::string_view> referenceLines(std::string_view buffer) {
+    std::vector<std::string_view> lines;
+    size_t start = 0;
+    while (start < buffer.size()) {
+        size_t newline = buffer.find('\n', start);
+        if (newline == std::string_view::npos) {
+            newline = buffer.size();
+        }
+        lines.push_back(buffer.substr(start, newline - start));
+        start = newline + 1;
+    }
+    return lines;
+}
+
+static void testMatching() {
+    std::mt19937 random(9);
+    // a small alphabet, so the needles turn up in most blocks
+    const std::string alphabet = "ab\n]\"";
+    std::string buffer(4 * SCAN_BLOCK_SIZE + 64, 'a');
+    for (int trial = 0; trial < 2000; ++trial) {
+        for (char& byte : buffer) {
+            byte = random() % 4 ? 'a' : alphabet[random() % alphabet.size()];
+        }
+        // a needle only at the very end, or nowhere
+        if (trial % 10 == 0) {
+            std::fill(buffer.begin(), buffer.end(), 'a');
+            if (trial % 20 == 0) {
+                buffer.back() = '\n';
+            }
+        }
+        for (size_t offset = 0; offset < SCAN_BLOCK_SIZE; ++offset) {
+            const char* block = buffer.data() + offset;
+            std::uint64_t expected = 0;
+            for (size_t i = 0; i < SCAN_BLOCK_SIZE; ++i) {
+                expected |= static_cast<std::uint64_t>(block[i] == '\n' || block[i] == '"') << i;
+            }
+            CHECK(matchBlock(block, '\n', '"') == expected);
+
+            size_t length = trial % (buffer.size() - offset + 1);
+            const char* end = block + length;
+            CHECK(findEither(block, end, '\n', '"') == referenceFind(block, end, '\n', '"'));
+            CHECK(findByte(block, end, ']') == referenceFind(block, end, ']', ']'));
+        }
+    }
+    CHECK(findByte(buffer.data(), buffer.data(), '\n') == buffer.data());
+}
+
+static void testClassify() {
+    struct Case {
+        std::string_view line;
+        LineRecord::Kind kind;
+        size_t valueOffset;
+        size_t count;
+    };
+    const Case cases[] = {
+        {"[X]", LineRecord::EndOfChildren, 0, 1},
+        {"[X*3]", LineRecord::EndOfChildren, 0, 3},
+        {"[X*120]", LineRecord::EndOfChildren, 0, 120},
+        {"[X*0]", LineRecord::Malformed, 0, 1},
+        {"[X*]", LineRecord::Malformed, 0, 1},
+        {"[X*2a]", LineRecord::Malformed, 0, 1},
+        {"[X*1234567890123456789]", LineRecord::Malformed, 0, 1},
+        {"[0]: value", LineRecord::NodeValue, 5, 1},
+        {"[12]: ", LineRecord::NodeValue, 6, 1},
+        {"[1]x]: value", LineRecord::NodeValue, 7, 1},
+        {"[1]:value", LineRecord::Malformed, 0, 1},
+        {"0]: value", LineRecord::Malformed, 0, 1},
+        {"", LineRecord::Malformed, 0, 1},
+    };
+    for (const Case& test : cases) {
+        LineRecord record = LineScanner::classify(test.line);
+        CHECK(record.line == test.line);
+        CHECK(record.kind == test.kind);
+        if (test.kind == LineRecord::NodeValue) {
+            CHECK(record.valueOffset == test.valueOffset);
+        }
+        if (test.kind == LineRecord::EndOfChildren) {
+            CHECK(record.count == test.count);
+        }
+    }
+}
+
+// Random buffers of tree lines, scanned in batches of every size from 1 up.
+static void testScanner() {
+    std::mt19937 random(13);
+    const std::string_view pieces[] = {"[0]: action: \"a\" outcome: \"b\"", "[X]", "[X*2]", "[17]: ]", "", "junk", "[3]: \"\\\"\""};
+    for (int trial = 0; trial < 500; ++trial) {
+        std::string buffer;
+        int lineCount = static_cast<int>(random() % 60);
+        for (int i = 0; i < lineCount; ++i) {
+            buffer += pieces[random() % std::size(pieces)];
+            buffer.push_back('\n');
+        }
+        // some buffers end without a newline, or with a line longer than a block
+        if (trial % 3 == 0) {
+            buffer += std::string(random() % (3 * SCAN_BLOCK_SIZE), 'v');
+        }
+
+        std::vector<std::string_view> expected = referenceLines(buffer);
+        size_t batchSize = 1 + static_cast<size_t>(trial % 8);
+        LineScanner scanner(buffer);
+        std::vector<LineRecord> records, scanned;
+        while (scanner.scan(records, batchSize)) {
+            CHECK(records.size() <= batchSize);
+            scanned.insert(scanned.end(), records.begin(), records.end());
+        }
+        CHECK(scanned.size() == expected.size());
+        for (size_t i = 0; i < scanned.size() && i < expected.size(); ++i) {
+            CHECK(scanned[i].line == expected[i]);
+            // views into the buffer, not copies
+            CHECK(scanned[i].line.data() == expected[i].data());
+            LineRecord reference = LineScanner::classify(expected[i]);
+            CHECK(scanned[i].kind == reference.kind);
+            CHECK(scanned[i].valueOffset == reference.valueOffset);
+            CHECK(scanned[i].count == reference.count);
+        }
+        // a finished scanner stays finished
+        CHECK(!scanner.scan(records, batchSize));
+        CHECK(records.empty());
+    }
+}
+
+int main() {
+    testMatching();
+    testClassify();
+    testScanner();
+    return testResult("LineScannerTests");
+}
\ No newline at end of file
@@ -0,0 +1,168 @@
+/**
+ * Tests for moving, detaching and grafting subtrees: the tree shape and IDs
+ * afterwards, the journal and path statistics they keep up to date, and the
+ * mapped storage that travels with detached and grafted nodes.
+ */
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "StoryNode.h"
+#include "TestSupport.h"
+#include "Tree.h"
+#include "utils.h"
+
+//          0
+//        /   \
+//       1     4
+//      / \     \
+//     2   3     5
+static Tree<int> sampleTree() {
+    Tree<int> tree(0);
+    int one = tree.appendNode(0, 1);
+    tree.appendNode(one, 2);
+    tree.appendNode(one, 3);
+    int four = tree.appendNode(0, 4);
+    tree.appendNode(four, 5);
+    return tree;
+}
+
+// Path statistics must match those computed from scratch for the same shape.
+static void checkStats(const Tree<int>& tree) {
+    Tree<int> fresh = Tree<int>::deserializeStrict(tree.serialize());
+    fresh.annotatePaths(true);
+    std::vector<int> ids, freshIDs;
+    for (const auto& node : tree.preOrder()) {
+        ids.push_back(node.id);
+    }
+    for (const auto& node : fresh.preOrder()) {
+        freshIDs.push_back(node.id);
+    }
+    CHECK(ids.size() == freshIDs.size());
+    for (size_t i = 0; i < ids.size() && i < freshIDs.size(); ++i) {
+        const auto& stats = tree.pathStats(ids[i]);
+        const auto& want = fresh.pathStats(freshIDs[i]);
+        CHECK(stats.depth == want.depth);
+        CHECK(stats.endingCount == want.endingCount);
+        CHECK(stats.minTurnsToEnding == want.minTurnsToEnding);
+        CHECK(stats.maxTurnsToEnding == want.maxTurnsToEnding);
+    }
+}
+
+static void testMove() {
+    Tree<int> tree = sampleTree();
+    tree.annotatePaths(true);
+    Tree<int> saved = sampleTree();
+    tree.trackChanges(true);
+
+    tree.moveSubtree(1, 5);
+    CHECK(tree.getChildrenIDs(0) == std::vector<int>{4});
+    CHECK(tree.getChildrenIDs(5) == std::vector<int>{1});
+    CHECK(tree.getChildrenIDs(1) == (std::vector<int>{2, 3}));
+    CHECK(tree.getValue(1) == 1 && tree.getValue(3) == 3);
+    CHECK(tree.pathStats(2).depth == 4);
+    checkStats(tree);
+
+    // a move among siblings puts the node last
+    tree.moveSubtree(2, 1);
+    CHECK(tree.getChildrenIDs(1) == (std::vector<int>{3, 2}));
+    checkStats(tree);
+
+    saved.applyJournal(tree.pendingChanges());
+    CHECK(saved.serialize() == tree.serialize());
+
+    std::string before = tree.serialize();
+    CHECK_THROWS(std::invalid_argument, tree.moveSubtree(0, 4));
+    CHECK_THROWS(std::invalid_argument, tree.moveSubtree(4, 1));
+    CHECK_THROWS(std::invalid_argument, tree.moveSubtree(1, 1));
+    CHECK_THROWS(std::invalid_argument, tree.moveSubtree(1, 99));
+    CHECK_THROWS(std::invalid_argument, tree.moveSubtree(99, 0));
+    CHECK(tree.serialize() == before);
+}
+
+static void testDetach() {
+    Tree<int> tree = sampleTree();
+    tree.annotatePaths(true);
+    tree.trackChanges(true);
+
+    Tree<int> detached = tree.detachSubtree(1);
+    CHECK(tree.serialize() == "[0]: 0\n[1]: 4\n[2]: 5\n[X]\n[X]\n[X]\n");
+    CHECK(tree.getChildrenIDs(0) == std::vector<int>{4});
+    CHECK_THROWS(std::invalid_argument, tree.getValue(1));
+    CHECK_THROWS(std::invalid_argument, tree.getValue(2));
+    CHECK(tree.pendingChanges() == "-[/0]\n");
+    checkStats(tree);
+
+    // the detached nodes are numbered afresh in pre-order
+    CHECK(detached.getRootID() == 0);
+    CHECK(detached.getChildrenIDs(0) == (std::vector<int>{1, 2}));
+    CHECK(detached.getValue(0) == 1 && detached.getValue(1) == 2 && detached.getValue(2) == 3);
+    CHECK(detached.appendNode(0, 6) == 3);
+
+    // released IDs are not reused
+    CHECK(tree.appendNode(0, 7) == 6);
+
+    CHECK_THROWS(std::invalid_argument, tree.detachSubtree(0));
+    CHECK_THROWS(std::invalid_argument, tree.detachSubtree(1));
+}
+
+static void testGraft() {
+    Tree<int> tree = sampleTree();
+    tree.annotatePaths(true);
+    Tree<int> saved = sampleTree();
+    tree.trackChanges(true);
+
+    Tree<int> branch(10);
+    branch.appendNode(0, 11);
+    branch.appendNode(0, 12);
+    int grafted = tree.graftSubtree(5, std::move(branch));
+    CHECK(grafted == 6);
+    CHECK(tree.getChildrenIDs(6) == (std::vector<int>{7, 8}));
+    CHECK(tree.getValue(8) == 12);
+    CHECK(branch.getRootID() == -1);
+    CHECK(tree.pathStats(7).depth == 4);
+    checkStats(tree);
+
+    saved.applyJournal(tree.pendingChanges());
+    CHECK(saved.serialize() == tree.serialize());
+
+    // detaching and grafting back restores the shape, under new IDs
+    std::string before = tree.serialize();
+    Tree<int> cut = tree.detachSubtree(4);
+    CHECK(tree.graftSubtree(0, std::move(cut)) == 9);
+    CHECK(tree.serialize() == before);
+    checkStats(tree);
+
+    Tree<int> empty;
+    CHECK_THROWS(std::invalid_argument, tree.graftSubtree(0, std::move(empty)));
+    CHECK_THROWS(std::invalid_argument, tree.graftSubtree(0, std::move(tree)));
+    Tree<int> orphan(1);
+    CHECK_THROWS(std::invalid_argument, tree.graftSubtree(99, std::move(orphan)));
+    CHECK(orphan.getRootID() == 0);
+}
+
+// Nodes viewing a mapped file keep it alive wherever they are moved to.
+static void testMappedStorage() {
+    Tree<StoryNodeView> mapped = loadStorylineMapped("varian_wrynn.txt");
+    Tree<StoryNode> story = loadStoryline("varian_wrynn.txt");
+    int branch = mapped.getChildrenIDs(mapped.getRootID()).front();
+    StoryNode expected = story.getValue(story.getChildrenIDs(story.getRootID()).front());
+
+    Tree<StoryNodeView> detached = mapped.detachSubtree(branch);
+    mapped = Tree<StoryNodeView>();
+    CHECK(detached.getValue(0).toStoryNode() == expected);
+
+    Tree<StoryNodeView> host(StoryNodeView{"host", "tree"});
+    host.graftSubtree(0, std::move(detached));
+    detached = Tree<StoryNodeView>();
+    CHECK(host.getValue(1).toStoryNode() == expected);
+}
+
+int main() {
+    testMove();
+    testDetach();
+    testGraft();
+    testMappedStorage();
+    return testResult("SpliceTests");
+}
\ No newline at end of file
@@ -0,0 +1,63 @@
+/**
+ * Minimal checking helpers shared by the test programs in tests/.
+ *
+ * Each test program is a plain executable registered with CTest. Checks stay
+ * active in release builds, unlike assert(); a failing check prints its
+ * expression and location and the run continues, so one run reports every
+ * failure. `testResult()` turns the tally into the exit code CTest reads.
+ *
+ * Built and run by the test targets in CMakeLists.txt:
+ *     cmake -S . -B build && cmake --build build && ctest --test-dir build
+ */
+
+#ifndef TESTSUPPORT_H
+#define TESTSUPPORT_H
+
+#include <iostream>
+
+// Number of checks that have failed so far in this program.
+inline int& testFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+// Records a failed check; used by the CHECK macros.
+inline void reportFailure(const char* expression, const char* file, int line) {
+    std::cerr << file << ":" << line << ": check failed: " << expression << std::endl;
+    ++testFailures();
+}
+
+// Checks that an expression is true.
+#define CHECK(expression) \
+    ((expression) ? static_cast<void>(0) : reportFailure(#expression, __FILE__, __LINE__))
+
+// Checks that a statement throws an exception of the given type.
+#define CHECK_THROWS(ExceptionType, statement)                                                  \
+    do {                                                                                        \
+        bool thrown = false;                                                                    \
+        try {                                                                                   \
+            statement;                                                                          \
+        } catch (const ExceptionType&) {                                                        \
+            thrown = true;                                                                      \
+        }                                                                                       \
+        if (!thrown) {                                                                          \
+            reportFailure(#statement " throws " #ExceptionType, __FILE__, __LINE__);             \
+        }                                                                                       \
+    } while (false)
+
+/**
+ * @brief Prints the outcome of a test program.
+ *
+ * @param name Name of the program, for the summary line.
+ * @return int Exit code: 0 if every check passed, 1 otherwise.
+ */
+inline int testResult(const char* name) {
+    if (testFailures() == 0) {
+        std::cout << name << ": all checks passed" << std::endl;
+        return 0;
+    }
+    std::cerr << name << ": " << testFailures() << " check(s) failed" << std::endl;
+    return 1;
+}
+
+#endif // TESTSUPPORT_H
\ No newline at end of file
@@ -0,0 +1,124 @@
+/**
+ * Tests for ThreadPool, its TaskGroups and the parallel tree helpers.
+ *
+ * The group stress test is most useful under a sanitizer, which reports a task
+ * touching a group after the group's waiter has destroyed it:
+ *     cmake -S . -B build -DCMAKE_CXX_FLAGS=-fsanitize=thread && cmake --build build
+ *     ctest --test-dir build -R ThreadPoolTests
+ */
+
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "ParallelTree.h"
+#include "TestSupport.h"
+#include "ThreadPool.h"
+#include "Tree.h"
+
+// Many short-lived groups, each destroyed as soon as wait() returns, while
+// the workers may still be finishing the group's last task.
+static void testShortLivedGroups(ThreadPool& pool) {
+    std::atomic<int> ran{0};
+    for (int round = 0; round < 20000; ++round) {
+        // on the heap, so a sanitizer sees any access after the group is gone
+        auto group = std::make_unique<ThreadPool::TaskGroup>(pool);
+        int tasks = 1 + round % 4;
+        for (int i = 0; i < tasks; ++i) {
+            group->submit([&ran]() { ran.fetch_add(1, std::memory_order_relaxed); });
+        }
+        group->wait();
+        group.reset();
+    }
+    int expected = 0;
+    for (int round = 0; round < 20000; ++round) {
+        expected += 1 + round % 4;
+    }
+    CHECK(ran.load() == expected);
+}
+
+// Groups on the stack of a pool task, waited on from inside the pool.
+static void testNestedGroups(ThreadPool& pool) {
+    std::atomic<int> leaves{0};
+    ThreadPool::TaskGroup outer(pool);
+    for (int i = 0; i < 64; ++i) {
+        outer.submit([&pool, &leaves]() {
+            ThreadPool::TaskGroup inner(pool);
+            for (int j = 0; j < 16; ++j) {
+                inner.submit([&leaves]() { leaves.fetch_add(1); });
+            }
+            inner.wait();
+        });
+    }
+    outer.wait();
+    CHECK(leaves.load() == 64 * 16);
+}
+
+static void testGroupErrors(ThreadPool& pool) {
+    ThreadPool::TaskGroup group(pool);
+    std::atomic<int> ran{0};
+    for (int i = 0; i < 32; ++i) {
+        group.submit([i, &ran]() {
+            ran.fetch_add(1);
+            if (i % 8 == 3) {
+                throw std::runtime_error("task failed");
+            }
+        });
+    }
+    CHECK_THROWS(std::runtime_error, group.wait());
+    CHECK(ran.load() == 32);
+    // the error is reported once; the group is reusable afterwards
+    group.submit([]() {});
+    group.wait();
+
+    // a group's error doesn't leak into the pool-wide wait, and vice versa
+    pool.submit([]() { throw std::logic_error("pool task failed"); });
+    CHECK_THROWS(std::logic_error, pool.wait());
+    pool.wait();
+}
+
+static void testPoolWaitFromTask(ThreadPool& pool) {
+    std::atomic<bool> refused{false};
+    ThreadPool::TaskGroup group(pool);
+    group.submit([&pool, &refused]() {
+        try {
+            pool.wait();
+        } catch (const std::logic_error&) {
+            refused = true;
+        }
+    });
+    group.wait();
+    CHECK(refused.load());
+}
+
+static void testParallelTree(ThreadPool& pool) {
+    Tree<int> tree(0);
+    std::vector<int> ids{0};
+    for (int i = 1; i < 5000; ++i) {
+        ids.push_back(tree.appendNode(ids[static_cast<size_t>(i) / 3], i));
+    }
+    long long expected = 4999LL * 5000 / 2;
+    for (int round = 0; round < 50; ++round) {
+        std::atomic<long long> visited{0};
+        parallelForEachSubtree(tree, pool, [&](const Tree<int>::NodeRef& node) { visited.fetch_add(node.value); });
+        CHECK(visited.load() == expected);
+        long long sum = parallelReduce(tree, pool, 0LL, [](const Tree<int>::NodeRef& node) { return static_cast<long long>(node.value); },
+                                       [](long long a, long long b) { return a + b; });
+        CHECK(sum == expected);
+    }
+    Tree<int> empty;
+    CHECK(parallelReduce(empty, pool, 7, [](const Tree<int>::NodeRef&) { return 1; }, [](int a, int b) { return a + b; }) == 7);
+}
+
+int main() {
+    for (unsigned threads : {1u, 4u}) {
+        ThreadPool pool(threads);
+        testShortLivedGroups(pool);
+        testNestedGroups(pool);
+        testGroupErrors(pool);
+        testPoolWaitFromTask(pool);
+        testParallelTree(pool);
+    }
+    return testResult("ThreadPoolTests");
+}
\ No newline at end of file
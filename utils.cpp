@@ -1,38 +1,623 @@
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
 #include <fstream>
+#include <future>
 #include <iostream>
+#include <memory>
+#include <optional>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
+#include "LineScanner.h"
+#include "MappedFile.h"
+#include "ParallelTree.h"
 #include "StoryNode.h"
+#include "StringPool.h"
 #include "Tree.h"
+#include "TreeMetrics.h"
 #include "utils.h"
 
-void saveStoryline(Tree<StoryNode> tree, std::string filePath) {
-    std::ofstream outFile(filePath);
-    if (!outFile) {
+// Prints a failed status the way the non-try functions always have.
+static void report(const StoryStatus& status) {
+    if (status.error == StoryError::OpenFailed) {
         std::cerr << "Unable to open file" << std::endl;
-        return;
+    } else if (!status) {
+        std::cerr << "Error: " << status.message << std::endl;
+    }
+}
+
+static StoryStatus failure(StoryError error, std::string message) {
+    return StoryStatus{error, std::move(message)};
+}
+
+// Writes a full snapshot of the tree, streaming it through a large file buffer.
+static StoryStatus writeStoryline(const Tree<StoryNode>& tree, const std::filesystem::path& filePath, StoryFormat format) {
+    TREE_METRICS_TIME(saveLatency);
+    // a larger buffer than the default so big trees are written in few syscalls;
+    // it has to be installed before the file is opened
+    std::vector<char> buffer(1 << 16);
+    std::ofstream outFile;
+    outFile.rdbuf()->pubsetbuf(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    outFile.open(filePath, std::ios::binary);
+    if (!outFile) {
+        return failure(StoryError::OpenFailed, "Unable to open file");
     }
 
-    outFile << tree.serialize();
+    if (format == StoryFormat::Binary) {
+        tree.serializeBinary(outFile, true);
+    } else if (format == StoryFormat::Compressed) {
+        std::string compressed = tree.serializeCompressed();
+        outFile.write(compressed.data(), static_cast<std::streamsize>(compressed.size()));
+    } else {
+        tree.serialize(outFile);
+    }
+
+    TREE_METRICS_ADD(fileBytesWritten, std::max<std::streamoff>(outFile.tellp(), 0));
+    outFile.close();
+    if (!outFile) {
+        return failure(StoryError::WriteFailed, "Unable to write file");
+    }
+    return StoryStatus();
+}
+
+// Journal of edits made since the snapshot at filePath was written.
+static std::filesystem::path journalPath(const std::filesystem::path& filePath) {
+    std::filesystem::path journal = filePath;
+    journal += ".journal";
+    return journal;
+}
+
+// Reads a whole file into a caller-provided buffer, reusing its capacity.
+static StoryStatus readFile(const std::filesystem::path& filePath, std::string& buffer) {
+    std::error_code error;
+    std::uintmax_t size = std::filesystem::file_size(filePath, error);
+    std::ifstream inFile(filePath, std::ios::binary);
+    if (error || !inFile) {
+        return failure(StoryError::OpenFailed, "Unable to open file");
+    }
+    buffer.resize(static_cast<size_t>(size));
+    if (!inFile.read(buffer.data(), static_cast<std::streamsize>(buffer.size()))) {
+        return failure(StoryError::OpenFailed, "Unable to read file");
+    }
+    TREE_METRICS_ADD(fileBytesRead, buffer.size());
+    return StoryStatus();
+}
+
+// Applies the storyline's journal, if it has one, on top of a freshly loaded snapshot.
+// `buffer` receives the journal text and may be reused by the caller afterwards.
+static StoryStatus replayJournal(Tree<StoryNode>& tree, const std::filesystem::path& filePath, std::string& buffer) {
+    std::filesystem::path journal = journalPath(filePath);
+    std::error_code error;
+    if (!std::filesystem::exists(journal, error)) {
+        return StoryStatus();
+    }
+    StoryStatus status = readFile(journal, buffer);
+    if (!status) {
+        return status;
+    }
+    try {
+        tree.applyJournal(buffer);
+    } catch (const std::exception& e) {
+        return failure(StoryError::Malformed, e.what());
+    }
+    return StoryStatus();
+}
+
+// Strictly decodes a snapshot and its journal; `data` may live in `buffer`, which is reused for the journal.
+static StoryResult<Tree<StoryNode>> decodeStoryline(std::string_view data, const std::filesystem::path& filePath,
+                                                    std::string& buffer) {
+    StoryResult<Tree<StoryNode>> result;
+    try {
+        result.value = isCompressedTree(data) ? Tree<StoryNode>::deserializeCompressedStrict(data)
+                     : isBinaryTree(data)     ? Tree<StoryNode>::deserializeBinaryStrict(data)
+                                              : Tree<StoryNode>::deserializeStrict(data);
+    } catch (const std::exception& e) {
+        result.status = failure(StoryError::Malformed, e.what());
+        return result;
+    }
+    result.status = replayJournal(result.value, filePath, buffer);
+    if (!result.status) {
+        // a journal that fails partway leaves some of its edits applied
+        result.value = Tree<StoryNode>();
+    }
+    return result;
+}
+
+void saveStoryline(const Tree<StoryNode>& tree, const std::filesystem::path& filePath, StoryFormat format) {
+    report(writeStoryline(tree, filePath, format));
+}
+
+StoryStatus trySaveStoryline(const Tree<StoryNode>& tree, const std::filesystem::path& filePath, StoryFormat format) {
+    return writeStoryline(tree, filePath, format);
+}
+
+StoryStatus trySaveStoryline(const Tree<StoryNode>& tree, const std::filesystem::path& filePath, StoryFormat format,
+                             std::string& buffer) {
+    TREE_METRICS_TIME(saveLatency);
+    buffer.clear();
+    if (format == StoryFormat::Binary) {
+        tree.serializeBinary(buffer, true);
+    } else if (format == StoryFormat::Compressed) {
+        tree.serializeCompressed(buffer);
+    } else {
+        tree.serialize(buffer);
+    }
 
+    std::ofstream outFile(filePath, std::ios::binary);
+    if (!outFile) {
+        return failure(StoryError::OpenFailed, "Unable to open file");
+    }
+    outFile.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
     outFile.close();
+    if (!outFile) {
+        return failure(StoryError::WriteFailed, "Unable to write file");
+    }
+    TREE_METRICS_ADD(fileBytesWritten, buffer.size());
+    return StoryStatus();
 }
 
-Tree<StoryNode> loadStoryline(std::string filePath) {
-    std::ifstream inFile(filePath);
-    if (!inFile) {
+void saveStorylineIncremental(Tree<StoryNode>& tree, const std::filesystem::path& filePath, size_t compactThreshold,
+                              StoryFormat format) {
+    std::filesystem::path journalFile = journalPath(filePath);
+    std::error_code error;
+    bool haveSnapshot = std::filesystem::exists(filePath, error);
+    std::uintmax_t journalSize = std::filesystem::exists(journalFile, error) ? std::filesystem::file_size(journalFile, error) : 0;
+
+    // without tracking the tree's edits are unknown, so only a full snapshot is safe
+    if (!tree.isTrackingChanges() || !haveSnapshot || journalSize + tree.pendingChanges().size() > compactThreshold) {
+        // write the snapshot beside the old one, and drop the journal before swapping it in,
+        // so an interrupted save never replays old edits over the new snapshot
+        std::filesystem::path tempFile = filePath;
+        tempFile += ".tmp";
+        StoryStatus status = writeStoryline(tree, tempFile, format);
+        if (!status) {
+            report(status);
+            return;
+        }
+        std::filesystem::remove(journalFile, error);
+        std::filesystem::rename(tempFile, filePath, error);
+        if (error) {
+            report(failure(StoryError::WriteFailed, error.message()));
+            return;
+        }
+    } else if (!tree.pendingChanges().empty()) {
+        std::ofstream outFile(journalFile, std::ios::binary | std::ios::app);
+        if (!outFile) {
+            report(failure(StoryError::OpenFailed, "Unable to open file"));
+            return;
+        }
+        outFile.write(tree.pendingChanges().data(), static_cast<std::streamsize>(tree.pendingChanges().size()));
+        outFile.close();
+        if (!outFile) {
+            report(failure(StoryError::WriteFailed, "Unable to write file"));
+            return;
+        }
+        TREE_METRICS_ADD(fileBytesWritten, tree.pendingChanges().size());
+    }
+
+    tree.clearChanges();
+    tree.trackChanges(true);
+}
+
+Tree<StoryNode> loadStoryline(const std::filesystem::path& filePath) {
+    TREE_METRICS_TIME(loadLatency);
+    // map the file rather than reading it line by line; both decoders work on the mapped bytes
+    std::unique_ptr<MappedFile> mapping;
+    try {
+        mapping = std::make_unique<MappedFile>(filePath.string());
+    } catch (const std::exception&) {
         std::cerr << "Unable to open file" << std::endl;
         return Tree<StoryNode>();
     }
 
-    std::string story;
-    std::string line;
+    mapping->prefetch();
+    std::string_view story = mapping->data();
+    TREE_METRICS_ADD(fileBytesRead, story.size());
+    Tree<StoryNode> tree = isCompressedTree(story) ? Tree<StoryNode>::deserializeCompressed(story)
+                         : isBinaryTree(story)     ? Tree<StoryNode>::deserializeBinary(story)
+                                                   : Tree<StoryNode>::deserialize(story);
+    std::string journal;
+    report(replayJournal(tree, filePath, journal));
+    return tree;
+}
+
+StoryResult<Tree<StoryNode>> tryLoadStoryline(const std::filesystem::path& filePath) {
+    TREE_METRICS_TIME(loadLatency);
+    std::unique_ptr<MappedFile> mapping;
+    try {
+        mapping = std::make_unique<MappedFile>(filePath.string());
+    } catch (const std::exception&) {
+        StoryResult<Tree<StoryNode>> result;
+        result.status = failure(StoryError::OpenFailed, "Unable to open file");
+        return result;
+    }
+    // the rest of the file is read in the background while the start is parsed
+    mapping->prefetch();
+    TREE_METRICS_ADD(fileBytesRead, mapping->data().size());
+    std::string journal;
+    return decodeStoryline(mapping->data(), filePath, journal);
+}
+
+StoryResult<Tree<StoryNode>> tryLoadStoryline(const std::filesystem::path& filePath, std::string& buffer) {
+    TREE_METRICS_TIME(loadLatency);
+    StoryResult<Tree<StoryNode>> result;
+    result.status = readFile(filePath, buffer);
+    if (!result.status) {
+        return result;
+    }
+    // the snapshot is fully decoded before the journal is read, so both can share the buffer
+    return decodeStoryline(buffer, filePath, buffer);
+}
+
+// Runs work on the pool, delivering its result, or the exception it threw, through a future.
+template <typename Result, typename Work>
+static std::future<Result> runOnPool(ThreadPool& pool, Work work) {
+    auto promise = std::make_shared<std::promise<Result>>();
+    std::future<Result> future = promise->get_future();
+    pool.submit([promise, work = std::move(work)]() {
+        try {
+            promise->set_value(work());
+        } catch (...) {
+            promise->set_exception(std::current_exception());
+        }
+    });
+    return future;
+}
+
+std::future<StoryResult<Tree<StoryNode>>> loadStorylineAsync(const std::filesystem::path& filePath, ThreadPool& pool) {
+    return runOnPool<StoryResult<Tree<StoryNode>>>(pool, [filePath]() { return tryLoadStoryline(filePath); });
+}
+
+std::future<StoryStatus> saveStorylineAsync(const Tree<StoryNode>& tree, const std::filesystem::path& filePath, ThreadPool& pool,
+                                            StoryFormat format) {
+    const Tree<StoryNode>* source = &tree;
+    return runOnPool<StoryStatus>(pool, [source, filePath, format]() { return trySaveStoryline(*source, filePath, format); });
+}
+
+Tree<StoryNode> loadStorylineParallel(const std::filesystem::path& filePath, unsigned threadCount) {
+    TREE_METRICS_TIME(loadLatency);
+    try {
+        MappedFile mapping(filePath.string());
+        std::string_view story = mapping.data();
+        TREE_METRICS_ADD(fileBytesRead, story.size());
+        Tree<StoryNode> tree = isCompressedTree(story) ? Tree<StoryNode>::deserializeCompressed(story)
+                             : isBinaryTree(story)     ? Tree<StoryNode>::deserializeBinary(story)
+                                                       : Tree<StoryNode>::deserializeParallel(story, threadCount);
+        std::string journal;
+        report(replayJournal(tree, filePath, journal));
+        return tree;
+    } catch (const std::runtime_error&) {
+        std::cerr << "Unable to open file" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+    }
+    return Tree<StoryNode>();
+}
+
+// A mapped story file, plus unescaped copies of any fields that cannot be viewed in place.
+struct MappedStory {
+    explicit MappedStory(const std::string& filePath) : file(filePath) {}
+
+    MappedFile file;
+    std::deque<std::string> unescaped;
+};
+
+// Builds a view tree from text-format data, one node line at a time, without copying the text.
+// Fields containing escape sequences are unescaped into `unescaped`, which must outlive the tree.
+static Tree<StoryNodeView> deserializeViews(std::string_view story, std::deque<std::string>& unescaped) {
+    std::vector<std::optional<StoryNodeView>> linearized;
+    size_t openNodes = 0, lineNumber = 0;
+    LineScanner scanner(story);
+    std::vector<LineRecord> records;
+
+    try {
+
+    while (scanner.scan(records)) {
+        for (LineRecord record : records) {
+            ++lineNumber;
+            // tolerate files saved with CRLF line endings
+            if (record.kind == LineRecord::Malformed && !record.line.empty() && record.line.back() == '\r') {
+                record = LineScanner::classify(record.line.substr(0, record.line.size() - 1));
+            }
+
+            // Handle end-of-children tokens
+            if (record.kind == LineRecord::EndOfChildren) {
+                if (record.count > openNodes) {
+                    throw std::invalid_argument("too many end-of-children tokens");
+                }
+                openNodes -= record.count;
+                linearized.insert(linearized.end(), record.count, std::nullopt);
+            // Handle node values
+            } else if (record.kind == LineRecord::NodeValue) {
+                std::string_view valuePart = record.value();
+                StoryNodeView node;
+                if (!parseView(valuePart, node)) {
+                    StoryNode owned;
+                    if (!parse(valuePart, owned)) {
+                        throw std::invalid_argument("unable to parse value");
+                    }
+                    node.action = unescaped.emplace_back(std::move(owned.action));
+                    node.outcome = unescaped.emplace_back(std::move(owned.outcome));
+                }
+                if (openNodes == 0 && !linearized.empty()) {
+                    throw std::invalid_argument("node found after the root's subtree ended");
+                }
+                openNodes++;
+                linearized.push_back(node);
+            // Invalid line format
+            } else {
+                throw std::invalid_argument("invalid line format");
+            }
+        }
+    }
+
+    if (openNodes != 0) {
+        throw std::invalid_argument("too few end-of-children tokens");
+    }
+    } catch (std::exception& e) {
+        std::cerr << "Error: Invalid tree serialization: " << e.what() << " (line " << lineNumber << ")" << std::endl;
+    }
+
+    return Tree<StoryNodeView>::fromLinearized(std::move(linearized));
+}
+
+Tree<StoryNodeView> loadStorylineMapped(const std::filesystem::path& filePath) {
+    std::shared_ptr<MappedStory> mapping;
+    try {
+        mapping = std::make_shared<MappedStory>(filePath.string());
+    } catch (const std::exception&) {
+        std::cerr << "Unable to open file" << std::endl;
+        return Tree<StoryNodeView>();
+    }
+
+    std::string_view story = mapping->file.data();
+    if (isCompressedTree(story)) {
+        // a compressed file has no text to point into
+        std::cerr << "Error: compressed storylines can't be viewed in place; use loadStoryline" << std::endl;
+        return Tree<StoryNodeView>();
+    }
+    Tree<StoryNodeView> tree = isBinaryTree(story) ? Tree<StoryNodeView>::deserializeBinary(story)
+                                                   : deserializeViews(story, mapping->unescaped);
+    tree.retainStorage(std::move(mapping));
+    return tree;
+}
+
+LazyTree<StoryNode> openStorylineLazy(const std::filesystem::path& filePath, size_t cacheCapacity) {
+    std::shared_ptr<MappedFile> file;
+    try {
+        file = std::make_shared<MappedFile>(filePath.string());
+    } catch (const std::exception&) {
+        std::cerr << "Unable to open file" << std::endl;
+        return LazyTree<StoryNode>();
+    }
+
+    try {
+        std::string_view story = file->data();
+        return LazyTree<StoryNode>(story, cacheCapacity, std::move(file));
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return LazyTree<StoryNode>();
+    }
+}
+
+// Rebuilds a tree of StoryNode-like values with their text interned in `pool`, which the new tree keeps alive.
+template <typename Source>
+static Tree<InternedStoryNode> internTree(const Tree<Source>& tree, std::shared_ptr<StringPool> pool) {
+    std::vector<std::optional<InternedStoryNode>> linearized;
+    size_t openNodes = 0;
+    tree.visit([&](const typename Tree<Source>::NodeRef& node, size_t depth) {
+        // close the nodes the pre-order walk has climbed back out of
+        for (; openNodes > depth; --openNodes) {
+            linearized.push_back(std::nullopt);
+        }
+        linearized.push_back(InternedStoryNode{pool->intern(node.value.action), pool->intern(node.value.outcome)});
+        ++openNodes;
+    });
+    linearized.insert(linearized.end(), openNodes, std::nullopt);
+
+    Tree<InternedStoryNode> interned = Tree<InternedStoryNode>::fromLinearized(std::move(linearized));
+    interned.retainStorage(std::move(pool));
+    return interned;
+}
+
+// Decodes a binary storyline with a string table, interning the table into `pool`.
+static Tree<InternedStoryNode> decodeInterned(std::string_view data, StringPool& pool) {
+    if (data.size() < BINARY_TREE_HEADER_SIZE ||
+        static_cast<std::uint8_t>(data[BINARY_TREE_MAGIC_SIZE]) != BINARY_TREE_VERSION_UNCHAINED) {
+        throw std::invalid_argument("Invalid binary tree: unsupported version");
+    }
+    if (binaryTreeFlags(data) & ~BINARY_TREE_KNOWN_FLAGS) {
+        throw std::invalid_argument("Invalid binary tree: unknown flags");
+    }
+    const char* cursor = data.data() + BINARY_TREE_HEADER_SIZE;
+    const char* end = data.data() + data.size();
+
+    // every string needs at least its length byte
+    std::uint64_t stringCount = readVarint(cursor, end);
+    if (stringCount > static_cast<std::uint64_t>(end - cursor)) {
+        throw std::invalid_argument("Invalid binary tree: string count exceeds data size");
+    }
+    std::vector<std::string_view> table;
+    table.reserve(stringCount);
+    for (std::uint64_t i = 0; i < stringCount; ++i) {
+        table.push_back(pool.intern(readLengthPrefixed(cursor, end)));
+    }
+    auto lookup = [&](std::uint64_t index) {
+        if (index >= table.size()) {
+            throw std::invalid_argument("Invalid binary tree: string index out of range");
+        }
+        return table[index];
+    };
+
+    // every node needs a child count and two string indices
+    std::uint64_t nodeCount = readVarint(cursor, end);
+    if (nodeCount > static_cast<std::uint64_t>(end - cursor) / 3) {
+        throw std::invalid_argument("Invalid binary tree: node count exceeds data size");
+    }
+    std::vector<std::optional<InternedStoryNode>> linearized;
+    linearized.reserve(nodeCount * 2);
+    std::vector<std::uint64_t> remaining; // children left to read for each open node
+    for (std::uint64_t i = 0; i < nodeCount; ++i) {
+        if (i > 0 && remaining.empty()) {
+            throw std::invalid_argument("Invalid binary tree: nodes found after the root's subtree ended");
+        }
+        std::uint64_t childCount = readVarint(cursor, end);
+        std::string_view action = lookup(readVarint(cursor, end));
+        std::string_view outcome = lookup(readVarint(cursor, end));
+
+        if (!remaining.empty()) {
+            --remaining.back();
+        }
+        linearized.push_back(InternedStoryNode{action, outcome});
+        remaining.push_back(childCount);
+        while (!remaining.empty() && remaining.back() == 0) {
+            remaining.pop_back();
+            linearized.push_back(std::nullopt);
+        }
+    }
+    if (!remaining.empty()) {
+        throw std::invalid_argument("Invalid binary tree: fewer nodes than child counts require");
+    }
+    return Tree<InternedStoryNode>::fromLinearized(std::move(linearized));
+}
+
+Tree<InternedStoryNode> internStoryline(const Tree<StoryNode>& tree, std::shared_ptr<StringPool> pool) {
+    if (!pool) {
+        pool = std::make_shared<StringPool>();
+    }
+    return internTree(tree, std::move(pool));
+}
+
+void saveStorylineInterned(const Tree<InternedStoryNode>& tree, const std::filesystem::path& filePath) {
+    // number the distinct strings in order of first use
+    std::unordered_map<std::string_view, std::uint64_t> indices;
+    std::vector<std::string_view> table;
+    auto number = [&](std::string_view text) {
+        auto [entry, added] = indices.try_emplace(text, table.size());
+        if (added) {
+            table.push_back(text);
+        }
+        return entry->second;
+    };
+    std::string records;
+    size_t nodeCount = 0;
+    tree.visit([&](const Tree<InternedStoryNode>::NodeRef& node) {
+        writeVarint(records, tree.childCount(node.id));
+        writeVarint(records, number(node.value.action));
+        writeVarint(records, number(node.value.outcome));
+        ++nodeCount;
+    });
+
+    std::string header(BINARY_TREE_MAGIC, BINARY_TREE_MAGIC_SIZE);
+    header.push_back(static_cast<char>(BINARY_TREE_VERSION_UNCHAINED));
+    header.push_back(static_cast<char>(BINARY_TREE_FLAG_STRING_TABLE));
+    writeVarint(header, table.size());
+    for (std::string_view text : table) {
+        writeLengthPrefixed(header, text);
+    }
+    writeVarint(header, nodeCount);
 
-    while (std::getline(inFile, line)) {
-        story += line + "\n";
+    std::ofstream outFile(filePath, std::ios::binary);
+    if (!outFile) {
+        std::cerr << "Unable to open file" << std::endl;
+        return;
     }
+    outFile.write(header.data(), static_cast<std::streamsize>(header.size()));
+    outFile.write(records.data(), static_cast<std::streamsize>(records.size()));
+    outFile.close();
+    if (!outFile) {
+        std::cerr << "Error: Unable to write file" << std::endl;
+    }
+}
+
+Tree<InternedStoryNode> loadStorylineInterned(const std::filesystem::path& filePath, std::shared_ptr<StringPool> pool) {
+    std::unique_ptr<MappedFile> mapping;
+    try {
+        mapping = std::make_unique<MappedFile>(filePath.string());
+    } catch (const std::exception&) {
+        std::cerr << "Unable to open file" << std::endl;
+        return Tree<InternedStoryNode>();
+    }
+    if (!pool) {
+        pool = std::make_shared<StringPool>();
+    }
+
+    std::string_view story = mapping->data();
+    if (isBinaryTree(story) && (binaryTreeFlags(story) & BINARY_TREE_FLAG_STRING_TABLE)) {
+        try {
+            Tree<InternedStoryNode> tree = decodeInterned(story, *pool);
+            tree.retainStorage(std::move(pool));
+            return tree;
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            return Tree<InternedStoryNode>();
+        }
+    }
+    if (isCompressedTree(story)) {
+        return internTree(Tree<StoryNode>::deserializeCompressed(story), std::move(pool));
+    }
+    // other formats are viewed in place first, so only the distinct strings are ever copied
+    std::deque<std::string> unescaped;
+    Tree<StoryNodeView> views = isBinaryTree(story) ? Tree<StoryNodeView>::deserializeBinary(story)
+                                                    : deserializeViews(story, unescaped);
+    return internTree(views, std::move(pool));
+}
+
+// A quote is dangling when a field holds an odd number of them.
+static bool hasDanglingQuote(std::string_view text) {
+    return std::count(text.begin(), text.end(), '"') % 2 != 0;
+}
+
+StorylineReport analyzeStoryline(const Tree<StoryNode>& tree, ThreadPool& pool, size_t maxOutcomeLength) {
+    auto check = [&tree, maxOutcomeLength](const Tree<StoryNode>::NodeRef& node, size_t depth) {
+        StorylineReport report;
+        report.nodeCount = 1;
+        report.maxDepth = depth;
+        size_t choices = tree.childCount(node.id);
+        if (choices == 0) {
+            report.endingCount = 1;
+            report.totalEndingDepth = depth;
+        }
+        report.chainNodeCount = choices == 1 ? 1 : 0;
 
-    inFile.close();
+        const StoryNode& story = node.value;
+        bool blankAction = std::all_of(story.action.begin(), story.action.end(),
+                                       [](unsigned char c) { return std::isspace(c); });
+        if (depth > 0 && blankAction) {
+            report.issues.push_back(StoryIssue{node.id, StoryIssue::Kind::EmptyAction});
+        }
+        if (hasDanglingQuote(story.action) || hasDanglingQuote(story.outcome)) {
+            report.issues.push_back(StoryIssue{node.id, StoryIssue::Kind::DanglingQuote});
+        }
+        if (story.outcome.size() > maxOutcomeLength) {
+            report.issues.push_back(StoryIssue{node.id, StoryIssue::Kind::OutcomeTooLong});
+        }
+        return report;
+    };
+    auto merge = [](StorylineReport total, StorylineReport part) {
+        total.nodeCount += part.nodeCount;
+        total.endingCount += part.endingCount;
+        total.maxDepth = std::max(total.maxDepth, part.maxDepth);
+        total.totalEndingDepth += part.totalEndingDepth;
+        total.chainNodeCount += part.chainNodeCount;
+        if (total.issues.empty()) {
+            total.issues = std::move(part.issues);
+        } else {
+            total.issues.insert(total.issues.end(), part.issues.begin(), part.issues.end());
+        }
+        return total;
+    };
 
-    return Tree<StoryNode>::deserialize(story);
+    StorylineReport report = parallelReduce(tree, pool, StorylineReport(), check, merge);
+    std::sort(report.issues.begin(), report.issues.end(),
+              [](const StoryIssue& a, const StoryIssue& b) { return a.nodeID < b.nodeID; });
+    return report;
 }
\ No newline at end of file
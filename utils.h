@@ -1,30 +1,311 @@
 #ifndef UTILS_H
 #define UTILS_H
 
+#include <cstddef>
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "LazyTree.h"
 #include "StoryNode.h"
+#include "StringPool.h"
+#include "ThreadPool.h"
 #include "Tree.h"
 
+/**
+ * @brief On-disk encodings supported for storylines
+ * 
+ * Text is the human-editable "[n]: value" / "[X]" format used for authoring.
+ * Binary is the compact length-prefixed format from Tree::serializeBinary(),
+ * which loads considerably faster. saveStoryline writes binary files with an
+ * index footer, so they can be opened lazily or read node by node.
+ * Compressed is the block-compressed container from Tree::serializeCompressed(),
+ * the smallest to store or transfer; lazy opening decompresses only the
+ * blocks that are visited.
+*/
+enum class StoryFormat {
+    Text,
+    Binary,
+    Compressed
+};
+
+/**
+ * @brief Why a storyline couldn't be loaded or saved
+*/
+enum class StoryError {
+    None,
+    OpenFailed,  // file missing, unreadable, or couldn't be created
+    WriteFailed, // file opened but the write didn't complete
+    Malformed    // file read but its contents (or journal) are invalid
+};
+
+/**
+ * @brief Outcome of a try* storyline operation
+ * 
+ * Converts to true on success. On failure, message describes the problem;
+ * nothing is printed, so callers can report it however suits them.
+*/
+struct StoryStatus {
+    StoryError error = StoryError::None;
+    std::string message;
+
+    explicit operator bool() const noexcept { return error == StoryError::None; }
+};
+
+/**
+ * @brief A loaded value together with the status of loading it
+ * 
+ * @tparam T type loaded; value is default-constructed (an empty tree) on failure
+*/
+template <typename T>
+struct StoryResult {
+    T value;
+    StoryStatus status;
+
+    explicit operator bool() const noexcept { return static_cast<bool>(status); }
+};
+
 /**
  * @brief Saves the storyline to a file
  * 
- * Calls tree.serialize() to get the serialized string and writes it to a file as is.
- * The tree handles the rest.
+ * Calls tree.serialize() (or tree.serializeBinary()) to get the serialized string
+ * and writes it to a file as is. The tree handles the rest.
  * 
  * @tparam T
+ * @param tree tree to save; only read, so callers keep it
+ * @param filePath file to save to
+ * @param format encoding to write, text by default
+*/
+void saveStoryline(const Tree<StoryNode>& tree, const std::filesystem::path& filePath, StoryFormat format = StoryFormat::Text);
+
+/**
+ * @brief Saves the storyline to a file, returning the outcome instead of printing it
+ * 
+ * @param tree tree to save
+ * @param filePath file to save to
+ * @param format encoding to write, text by default
+ * @return StoryStatus
+*/
+StoryStatus trySaveStoryline(const Tree<StoryNode>& tree, const std::filesystem::path& filePath,
+                             StoryFormat format = StoryFormat::Text);
+
+/**
+ * @brief Saves the storyline through a caller-provided buffer
+ * 
+ * The whole file is encoded into buffer and written with a single call. Reusing
+ * the same buffer across saves means no allocation once it has grown to fit.
+ * 
  * @param tree tree to save
  * @param filePath file to save to
+ * @param format encoding to write
+ * @param buffer scratch space; its contents are replaced
+ * @return StoryStatus
 */
-void saveStoryline(Tree<StoryNode> tree, std::string filePath);
+StoryStatus trySaveStoryline(const Tree<StoryNode>& tree, const std::filesystem::path& filePath, StoryFormat format,
+                             std::string& buffer);
+
+/**
+ * @brief Saves only the edits made since the last save, when possible
+ * 
+ * Appends the tree's pending changes (see Tree::trackChanges) to the journal
+ * kept beside the file at filePath + ".journal", so a save costs time
+ * proportional to the edits. A full snapshot is written instead, and the
+ * journal dropped, when there's no snapshot yet, when the tree wasn't tracking
+ * its changes, or when the journal would grow past compactThreshold bytes.
+ * Afterwards the tree's pending changes are cleared and tracking is on.
+ * loadStoryline and loadStorylineParallel replay the journal automatically.
+ * 
+ * @param tree tree to save; its pending changes are consumed
+ * @param filePath snapshot file; the journal lives next to it
+ * @param compactThreshold journal size in bytes above which a full snapshot is written
+ * @param format encoding for full snapshots, text by default
+*/
+void saveStorylineIncremental(Tree<StoryNode>& tree, const std::filesystem::path& filePath, size_t compactThreshold = 1 << 20,
+                              StoryFormat format = StoryFormat::Text);
 
 /**
  * @brief Loads the storyline from a file
  * 
  * Reads the file and returns a Tree<T> object using the serialized string.
+ * The format is picked from the file header, so text and binary files both load.
+ * Edits journaled by saveStorylineIncremental are replayed on top.
  * 
  * @tparam T
  * @param filePath file to load from
  * @return Tree<StoryNode>
 */
-Tree<StoryNode> loadStoryline(std::string filePath);
+Tree<StoryNode> loadStoryline(const std::filesystem::path& filePath);
+
+/**
+ * @brief Loads the storyline from a file, returning the outcome instead of printing it
+ * 
+ * Stricter than loadStoryline: any error in the file or its journal fails the
+ * whole load rather than returning the nodes read so far.
+ * 
+ * @param filePath file to load from
+ * @return StoryResult<Tree<StoryNode>>
+*/
+StoryResult<Tree<StoryNode>> tryLoadStoryline(const std::filesystem::path& filePath);
+
+/**
+ * @brief Loads the storyline by reading it into a caller-provided buffer
+ * 
+ * Intended for reloading the same storyline repeatedly: file and journal bytes
+ * go into buffer, which stops allocating once it has grown to fit them.
+ * 
+ * @param filePath file to load from
+ * @param buffer scratch space; its contents are replaced
+ * @return StoryResult<Tree<StoryNode>>
+*/
+StoryResult<Tree<StoryNode>> tryLoadStoryline(const std::filesystem::path& filePath, std::string& buffer);
+
+/**
+ * @brief Loads the storyline on a thread pool, without blocking the caller
+ * 
+ * Does the same work as tryLoadStoryline(filePath) as one task on pool, so many
+ * storylines can be loaded at once, e.g. when a server starts: each task has
+ * the OS read its file ahead in the background while it parses the part
+ * already read, and up to pool.size() files are read and parsed concurrently.
+ * 
+ * @param filePath file to load from
+ * @param pool threads to load on; must outlive the returned future
+ * @return std::future<StoryResult<Tree<StoryNode>>> ready once the storyline and its journal are loaded
+*/
+std::future<StoryResult<Tree<StoryNode>>> loadStorylineAsync(const std::filesystem::path& filePath, ThreadPool& pool);
+
+/**
+ * @brief Saves the storyline on a thread pool, without blocking the caller
+ * 
+ * Does the same work as trySaveStoryline(tree, filePath, format) as one task on pool.
+ * 
+ * @param tree storyline to save; must outlive the returned future and not be modified until it is ready
+ * @param filePath file to save into
+ * @param pool threads to save on; must outlive the returned future
+ * @param format encoding to write
+ * @return std::future<StoryStatus> ready once the file has been written
+*/
+std::future<StoryStatus> saveStorylineAsync(const Tree<StoryNode>& tree, const std::filesystem::path& filePath, ThreadPool& pool,
+                                            StoryFormat format = StoryFormat::Text);
+
+/**
+ * @brief Loads a large storyline using several threads
+ * 
+ * Maps the file and parses the root's child subtrees in parallel with
+ * Tree::deserializeParallel(). Binary files are decoded on the calling thread,
+ * since they have no text parsing to share out.
+ * 
+ * @param filePath file to load from
+ * @param threadCount number of worker threads; 0 uses the hardware concurrency
+ * @return Tree<StoryNode>
+*/
+Tree<StoryNode> loadStorylineParallel(const std::filesystem::path& filePath, unsigned threadCount = 0);
+
+/**
+ * @brief Loads the storyline from a memory-mapped file without copying its text
+ * 
+ * Maps the file and builds a tree whose action and outcome views point straight
+ * into the mapping. The returned tree owns the mapping, so the views stay valid
+ * for as long as the tree exists. Text and binary files are both accepted;
+ * compressed files have no text to point into and load as an empty tree.
+ * 
+ * @param filePath file to load from
+ * @return Tree<StoryNodeView>
+*/
+Tree<StoryNodeView> loadStorylineMapped(const std::filesystem::path& filePath);
+
+/**
+ * @brief Opens a storyline without decoding it up front
+ * 
+ * Maps the file and indexes its structure; node values are decoded only when
+ * first accessed, and at most cacheCapacity of them stay resident. Suited to
+ * storylines too large to load whole, where a playthrough visits a single path.
+ * 
+ * @param filePath file to open
+ * @param cacheCapacity maximum number of decoded nodes kept in memory
+ * @return LazyTree<StoryNode> empty if the file can't be opened or is malformed
+*/
+LazyTree<StoryNode> openStorylineLazy(const std::filesystem::path& filePath, size_t cacheCapacity = 4096);
+
+/**
+ * @brief Copies a storyline into interned form
+ * 
+ * Every action and outcome is interned in pool, so text repeated across nodes
+ * is stored once, and the returned tree keeps the pool alive. Nodes are
+ * renumbered in pre-order.
+ * 
+ * @param tree storyline to copy
+ * @param pool pool to intern into, e.g. to share one between trees; nullptr creates a new one
+ * @return Tree<InternedStoryNode> the interned storyline
+*/
+Tree<InternedStoryNode> internStoryline(const Tree<StoryNode>& tree, std::shared_ptr<StringPool> pool = nullptr);
+
+/**
+ * @brief Saves an interned storyline in the binary format, with its text stored once
+ * 
+ * The file begins with a table of every distinct string, and each node refers
+ * to its action and outcome by index into that table. Only loadStorylineInterned
+ * reads these files.
+ * 
+ * @param tree interned storyline to save
+ * @param filePath file to write
+*/
+void saveStorylineInterned(const Tree<InternedStoryNode>& tree, const std::filesystem::path& filePath);
+
+/**
+ * @brief Loads a storyline with all of its text interned
+ * 
+ * Reads files written by saveStorylineInterned as well as plain text and binary
+ * storylines; the file isn't kept open once its text has been interned. Any
+ * journal next to the file is not replayed.
+ * 
+ * @param filePath file to load
+ * @param pool pool to intern into; nullptr creates a new one, kept alive by the tree
+ * @return Tree<InternedStoryNode> empty if the file can't be opened or is malformed
+*/
+Tree<InternedStoryNode> loadStorylineInterned(const std::filesystem::path& filePath, std::shared_ptr<StringPool> pool = nullptr);
+
+/**
+ * @brief Something wrong with a single story node, found by analyzeStoryline
+*/
+struct StoryIssue {
+    enum class Kind {
+        EmptyAction,    // a choice with no text; only the root may have one
+        DanglingQuote,  // a field with an unmatched '"'
+        OutcomeTooLong  // outcome longer than the limit passed to analyzeStoryline
+    };
+
+    int nodeID;
+    Kind kind;
+};
+
+/**
+ * @brief Validation results and reachability statistics for a whole storyline
+*/
+struct StorylineReport {
+    size_t nodeCount = 0;
+    size_t endingCount = 0;  // nodes with no choices left
+    size_t maxDepth = 0;     // most choices on any path from the root
+    size_t totalEndingDepth = 0; // sum of the depths of every ending, for the mean path length
+    size_t chainNodeCount = 0; // nodes offering exactly one choice, i.e. links of single-child chains
+    std::vector<StoryIssue> issues; // ordered by node ID
+
+    double meanEndingDepth() const noexcept {
+        return endingCount ? static_cast<double>(totalEndingDepth) / static_cast<double>(endingCount) : 0.0;
+    }
+};
+
+/**
+ * @brief Validates every node of a storyline and gathers reachability statistics
+ * 
+ * Independent subtrees are checked concurrently on the given pool.
+ * 
+ * @param tree storyline to check; must not be modified during the call
+ * @param pool threads to run the checks on
+ * @param maxOutcomeLength longest outcome, in bytes, that isn't reported
+ * @return StorylineReport the statistics and every issue found
+*/
+StorylineReport analyzeStoryline(const Tree<StoryNode>& tree, ThreadPool& pool, size_t maxOutcomeLength = 2048);
 
 #endif // UTILS_H
\ No newline at end of file